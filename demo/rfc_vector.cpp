@@ -1,16 +1,207 @@
 ﻿#include <iostream>
 #include <vector>
 #include <benchmarking/benchmark.hpp>
+#include <benchmarking/autotune.hpp>
+#include <benchmarking/channel_benchmark.hpp>
+#include <benchmarking/comparison.hpp>
 #include <chacha20_poly1305.hpp>
+#include <quic_protection.hpp>
 
 void test_performance() {
     // For performance test
 
     Benchmarking::set_high_priority();
+    Benchmarking::print_environment();
     Benchmarking::test_chacha20();
     Benchmarking::test_aead();
 }
 
+#if !defined(_WIN32) && !defined(_WIN64)
+void channel_empty_record_test() {
+    // A zero-length frame carrying a junk tag must fail like any other forged record
+    Benchmarking::ChannelPair pair;
+    uint8_t frame[SecureChannel::HEADER_SIZE + SecureChannel::TAG_SIZE] = { 0 };
+
+    if (::write(pair.fds[0], frame, sizeof(frame)) != static_cast<ssize_t>(sizeof(frame))) {
+        throw std::runtime_error("Could not inject the empty record");
+    }
+    shutdown(pair.fds[0], SHUT_WR); // Skipping the frame would then read as end of stream
+
+    SecureChannel::FramedChannel in(pair.fds[1], Benchmarking::CHANNEL_KEY_B, Benchmarking::CHANNEL_KEY_A);
+
+    std::span<const uint8_t> record;
+    if (in.try_read_record(record) != CryptoHelper::Status::AuthenticationFailed) {
+        throw std::runtime_error("SecureChannel accepted an empty record");
+    }
+
+    // The channel stays failed, and the throwing API reports it too
+    try {
+        in.read_record();
+    }
+    catch (const std::runtime_error&) {
+        return;
+    }
+
+    throw std::runtime_error("SecureChannel accepted an empty record");
+}
+#endif
+
+void fixed_length_test() {
+    //
+    // RFC 8439 Test Vector, Section 2.8.2, through the compile-time fixed-length seal/open
+    //
+
+    uint8_t key_bytes[32];
+    for (size_t i = 0; i < 32; i++) key_bytes[i] = static_cast<uint8_t>(0x80 + i);
+
+    const uint8_t nonce_bytes[12] = { 0x07,0x00,0x00,0x00,0x40,0x41,0x42,0x43,0x44,0x45,0x46,0x47 };
+    const uint8_t aad[12] = { 0x50,0x51,0x52,0x53,0xc0,0xc1,0xc2,0xc3,0xc4,0xc5,0xc6,0xc7 };
+    const char text[] = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+
+    const uint8_t expected_ciphertext[114] = {
+        0xd3,0x1a,0x8d,0x34,0x64,0x8e,0x60,0xdb,0x7b,0x86,0xaf,0xbc,0x53,0xef,0x7e,0xc2,
+        0xa4,0xad,0xed,0x51,0x29,0x6e,0x08,0xfe,0xa9,0xe2,0xb5,0xa7,0x36,0xee,0x62,0xd6,
+        0x3d,0xbe,0xa4,0x5e,0x8c,0xa9,0x67,0x12,0x82,0xfa,0xfb,0x69,0xda,0x92,0x72,0x8b,
+        0x1a,0x71,0xde,0x0a,0x9e,0x06,0x0b,0x29,0x05,0xd6,0xa5,0xb6,0x7e,0xcd,0x3b,0x36,
+        0x92,0xdd,0xbd,0x7f,0x2d,0x77,0x8b,0x8c,0x98,0x03,0xae,0xe3,0x28,0x09,0x1b,0x58,
+        0xfa,0xb3,0x24,0xe4,0xfa,0xd6,0x75,0x94,0x55,0x85,0x80,0x8b,0x48,0x31,0xd7,0xbc,
+        0x3f,0xf4,0xde,0xf0,0x8e,0x4b,0x7a,0x9d,0xe5,0x76,0xd2,0x65,0x86,0xce,0xc6,0x4b,
+        0x61,0x16
+    };
+
+    const uint8_t expected_tag[16] = {
+        0x1a,0xe1,0x0b,0x59,0x4f,0x09,0xe2,0x6a,0x7e,0x90,0x2e,0xcb,0xd0,0x60,0x06,0x91
+    };
+
+    uint32_t key[8], nonce[3];
+    CryptoHelper::_8bitarray_to32bitarray(key_bytes, key, 32);
+    CryptoHelper::_8bitarray_to32bitarray(nonce_bytes, nonce, 12);
+    ChaCha20 c(key, nonce);
+
+    uint8_t plaintext[114], ciphertext[114], opened[114], tag[16];
+    std::memcpy(plaintext, text, sizeof(plaintext));
+
+    ChaCha20_Poly1305::seal<12, 114>(c, std::span<const uint8_t, 12>(aad), std::span<const uint8_t, 114>(plaintext),
+        std::span<uint8_t, 114>(ciphertext), std::span<uint8_t, 16>(tag));
+
+    if (std::memcmp(ciphertext, expected_ciphertext, 114) != 0 || std::memcmp(tag, expected_tag, 16) != 0) {
+        throw std::runtime_error("Fixed-length seal is not matching RFC Test Vector");
+    }
+
+    if (!ChaCha20_Poly1305::open<12, 114>(c, std::span<const uint8_t, 12>(aad), std::span<const uint8_t, 114>(ciphertext),
+        std::span<const uint8_t, 16>(tag), std::span<uint8_t, 114>(opened)) || std::memcmp(opened, plaintext, 114) != 0) {
+        throw std::runtime_error("Fixed-length open rejected the RFC Test Vector");
+    }
+
+    tag[15] ^= 0x01;
+    if (ChaCha20_Poly1305::open<12, 114>(c, std::span<const uint8_t, 12>(aad), std::span<const uint8_t, 114>(ciphertext),
+        std::span<const uint8_t, 16>(tag), std::span<uint8_t, 114>(opened))) {
+        throw std::runtime_error("Fixed-length open accepted a tampered tag");
+    }
+}
+
+void stream_resume_test() {
+    // Streaming seal/open interrupted at a checkpoint must match one-shot encrypt
+
+    uint32_t key[8] = { 0x03020100, 0x07060504, 0x0b0a0908, 0x0f0e0d0c, 0x13121110, 0x17161514, 0x1b1a1918, 0x1f1e1d1c };
+    uint32_t nonce[3] = { 0x00000007, 0x43424140, 0x47464544 };
+    uint32_t other_nonce[3] = { 0x00000008, 0x43424140, 0x47464544 };
+    uint32_t local_key[8] = { 0x5a5a5a5a, 1, 2, 3, 4, 5, 6, 7 };
+
+    const uint8_t aad[12] = { 0x50,0x51,0x52,0x53,0xc0,0xc1,0xc2,0xc3,0xc4,0xc5,0xc6,0xc7 };
+    std::vector<uint8_t> plaintext(1000), expected(plaintext.size()), output(plaintext.size());
+    for (size_t i = 0; i < plaintext.size(); i++) plaintext[i] = static_cast<uint8_t>(i * 7 + 3);
+
+    uint8_t expected_tag[16], tag[16];
+    ChaCha20 one_shot(key, nonce);
+    ChaCha20_Poly1305::encrypt(one_shot, plaintext.data(), plaintext.size(), aad, sizeof(aad), expected.data(), expected_tag);
+
+    for (size_t split : { 0, 1, 17, 64, 100, 999 }) {
+        uint8_t checkpoint[ChaCha20_Poly1305::Stream::CHECKPOINT_SIZE];
+        ChaCha20 c(key, nonce);
+
+        // Seal
+        {
+            ChaCha20_Poly1305::Stream first(c, ChaCha20_Poly1305::StreamMode::Seal, aad, sizeof(aad));
+            first.update(plaintext.data(), output.data(), split);
+            first.checkpoint(local_key, checkpoint);
+        }
+
+        ChaCha20_Poly1305::Stream sealed(c, local_key, checkpoint);
+        sealed.update(plaintext.data() + split, output.data() + split, plaintext.size() - split);
+        sealed.finish(tag);
+
+        if (output != expected || std::memcmp(tag, expected_tag, 16) != 0) {
+            throw std::runtime_error("Resumed stream seal is not matching one-shot encrypt");
+        }
+
+        // Open
+        {
+            ChaCha20_Poly1305::Stream first(c, ChaCha20_Poly1305::StreamMode::Open, aad, sizeof(aad));
+            first.update(expected.data(), output.data(), split);
+            first.checkpoint(local_key, checkpoint);
+        }
+
+        ChaCha20_Poly1305::Stream opened(c, local_key, checkpoint);
+        opened.update(expected.data() + split, output.data() + split, expected.size() - split);
+
+        if (!opened.verify(expected_tag) || output != plaintext) {
+            throw std::runtime_error("Resumed stream open is not matching the plaintext");
+        }
+
+        // A checkpoint only resumes the stream it was taken from
+        ChaCha20 other(key, other_nonce);
+        ChaCha20_Poly1305::Stream foreign(other, ChaCha20_Poly1305::StreamMode::Seal, nullptr, 0);
+        if (foreign.try_resume(local_key, checkpoint) != CryptoHelper::Status::AuthenticationFailed) {
+            throw std::runtime_error("Stream resumed from another stream's checkpoint");
+        }
+    }
+}
+
+void quic_packet_test() {
+    //
+    // RFC 9001 Test Vector, Appendix A.5 (ChaCha20-Poly1305 short header packet)
+    //
+
+    const uint8_t key[32] = {
+        0xc6,0xd9,0x8f,0xf3,0x44,0x1c,0x3f,0xe1,0xb2,0x18,0x20,0x94,0xf6,0x9c,0xaa,0x2e,
+        0xd4,0xb7,0x16,0xb6,0x54,0x88,0x96,0x0a,0x7a,0x98,0x49,0x79,0xfb,0x23,0xe1,0xc8
+    };
+    const uint8_t iv[12] = { 0xe0,0x45,0x9b,0x34,0x74,0xbd,0xd0,0xe4,0x4a,0x41,0xc1,0x44 };
+    const uint8_t hp_key[32] = {
+        0x25,0xa2,0x82,0xb9,0xe8,0x2f,0x06,0xf2,0x1f,0x48,0x89,0x17,0xa4,0xfc,0x8f,0x1b,
+        0x73,0x57,0x36,0x85,0x60,0x85,0x97,0xd0,0xef,0xcb,0x07,0x6b,0x0a,0xb7,0xa7,0xa4
+    };
+    const uint64_t packet_number = 654360564;
+
+    // Unprotected header 4200bff4, payload 01
+    const uint8_t unprotected[5] = { 0x42,0x00,0xbf,0xf4,0x01 };
+    const uint8_t expected_packet[21] = {
+        0x4c,0xfe,0x41,0x89,0x65,0x5e,0x5c,0xd5,0x5c,0x41,0xf6,0x90,0x80,0x57,0x5d,0x79,
+        0x99,0xc2,0x5a,0x5b,0xfb
+    };
+
+    uint8_t data[21] = { 0 };
+    std::memcpy(data, unprotected, sizeof(unprotected));
+
+    QuicProtection::PacketProtection sender(key, iv, hp_key);
+    QuicProtection::Packet packet = { data, 1, 3, 1 };
+    sender.seal(packet, packet_number);
+    sender.protect_headers(&packet, 1);
+
+    if (std::memcmp(data, expected_packet, sizeof(expected_packet)) != 0) {
+        throw std::runtime_error("QUIC packet protection is not matching RFC 9001 Test Vector");
+    }
+
+    QuicProtection::PacketProtection receiver(key, iv, hp_key);
+    QuicProtection::Packet received = { data, 1, 0, 1 };
+    receiver.unprotect_headers(&received, 1);
+
+    if (received.pn_len != 3 || !receiver.open(received, packet_number) || std::memcmp(data, unprotected, sizeof(unprotected)) != 0) {
+        throw std::runtime_error("QUIC packet does not round-trip through RFC 9001 Test Vector");
+    }
+}
+
 void rfc_test() {
     // For correctness test
 
@@ -137,12 +328,27 @@ void rfc_test() {
         throw std::runtime_error("ChaCha20 result is not matching RFC Test Vector");
     }
 
+    fixed_length_test();
+    stream_resume_test();
+    quic_packet_test();
+
+#if !defined(_WIN32) && !defined(_WIN64)
+    channel_empty_record_test();
+#endif
+
     std::cout << "Everything working just fine";
 }
 
 int main(int argc, char* argv[]) {
     // rfc_test(); // uncomment for correctness test
     test_performance(); // simple performance test
+    // Benchmarking::test_primitives(); // uncomment for per-stage cycle counts
+    // Benchmarking::load_or_calibrate(Benchmarking::default_tuning_path(), true); // uncomment to tune size thresholds for this CPU (cached per CPU model)
+    // Benchmarking::test_latency(); // uncomment for small-message tail latency (pass a target rate for open-loop pacing)
+    // Benchmarking::test_channel(); // uncomment for SecureChannel socketpair throughput and round-trip latency
+    // Benchmarking::test_cache_modes(); // uncomment for warm vs cold-cache vs first-touch throughput
+    // Benchmarking::test_energy(); // uncomment for RAPL energy per byte / per message (needs read access to /sys/class/powercap)
+    // Benchmarking::test_comparison(); // uncomment to cross-check and time against OpenSSL/libsodium (linked when CMake finds them)
 
     std::cout << "\nPress any key to exit..." << std::endl;
     std::cin.get();
@@ -0,0 +1,200 @@
+#pragma once
+#include <chacha20_poly1305.hpp>
+#include <coroutine>
+#include <concepts>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Awaitable ChaCha20-Poly1305 for coroutine based event loops.
+// Small messages run inline, large ones are handed to a bounded worker pool
+// and the awaiting coroutine is resumed through the caller's executor.
+
+namespace AsyncAEAD {
+    // Messages below Tuning::active().offload_threshold (default 64 KiB) run inline:
+    // under that size a pool round trip costs more than the work
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 256;
+
+    // Anything that can schedule a coroutine handle back onto its own thread(s)
+    template <typename E>
+    concept ResumeExecutor = requires(E& e, std::coroutine_handle<> h) {
+        e.post(h);
+    };
+
+    // Resumes on whichever thread finished the work
+    struct InlineExecutor {
+        void post(std::coroutine_handle<> h) { h.resume(); }
+    };
+
+    class CryptoWorkerPool {
+    public:
+        explicit CryptoWorkerPool(size_t threads, size_t capacity = DEFAULT_QUEUE_CAPACITY);
+        ~CryptoWorkerPool();
+
+        // Returns false instead of blocking when the queue is full (the caller then runs the job itself)
+        bool try_submit(std::function<void()> job);
+
+        static CryptoWorkerPool& shared() {
+            static CryptoWorkerPool pool(std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1);
+            return pool;
+        }
+
+        CryptoWorkerPool(const CryptoWorkerPool&) = delete;
+        CryptoWorkerPool& operator=(const CryptoWorkerPool&) = delete;
+    private:
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::deque<std::function<void()>> jobs;
+        std::vector<std::thread> workers;
+        size_t capacity;
+        bool stopping = false;
+
+        void run();
+    };
+
+    inline CryptoWorkerPool::CryptoWorkerPool(size_t threads, size_t capacity) : capacity(capacity) {
+        if (threads == 0 || capacity == 0) {
+            CRYPTO_THROW(std::invalid_argument("Worker pool needs at least one thread and one queue slot"));
+        }
+
+        workers.reserve(threads);
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back([this] { run(); });
+        }
+    }
+
+    inline CryptoWorkerPool::~CryptoWorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+
+        for (auto& w : workers) {
+            w.join();
+        }
+    }
+
+    inline bool CryptoWorkerPool::try_submit(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping || jobs.size() >= capacity) return false;
+            jobs.push_back(std::move(job));
+        }
+        cv.notify_one();
+
+        return true;
+    }
+
+    inline void CryptoWorkerPool::run() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (jobs.empty()) return; // stopping and drained
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+
+            job();
+        }
+    }
+
+    // Awaitable seal/open. The ChaCha20 and all buffers must stay alive and
+    // untouched until the co_await completes. Keep the ChaCha20 outside the
+    // coroutine frame: frames are not over-aligned on every compiler.
+    template <ResumeExecutor Executor, bool Open>
+    class AeadOperation {
+    public:
+        AeadOperation(Executor& executor, CryptoWorkerPool& pool, ChaCha20& c,
+            const uint8_t* input, size_t length,
+            const uint8_t* aad, size_t aad_len,
+            uint8_t* output, uint8_t* tag_out, const uint8_t* tag_in)
+            : executor(executor), pool(pool), c(c), input(input), length(length),
+            aad(aad), aad_len(aad_len), output(output), tag_out(tag_out), tag_in(tag_in) {}
+
+        bool await_ready() {
+            if (length >= Tuning::active().offload_threshold.load(std::memory_order_relaxed)) return false;
+
+            run();
+            return true;
+        }
+
+        bool await_suspend(std::coroutine_handle<> h) {
+            bool queued = pool.try_submit([this, h] {
+                run();
+                executor.post(h);
+            });
+
+            if (!queued) {
+                run(); // Pool saturated: do the work here and continue without suspending
+            }
+
+            return queued;
+        }
+
+        auto await_resume() {
+            if constexpr (Open) {
+                if (status == CryptoHelper::Status::AuthenticationFailed) return false;
+            }
+
+            if (status != CryptoHelper::Status::Ok) {
+                CRYPTO_THROW(std::invalid_argument(CryptoHelper::status_message(status)));
+            }
+
+            if constexpr (Open) {
+                return true;
+            }
+        }
+    private:
+        Executor& executor;
+        CryptoWorkerPool& pool;
+        ChaCha20& c;
+        const uint8_t* input;
+        size_t length;
+        const uint8_t* aad;
+        size_t aad_len;
+        uint8_t* output;
+        uint8_t* tag_out;
+        const uint8_t* tag_in;
+        CryptoHelper::Status status = CryptoHelper::Status::Ok;
+
+        // Runs on a worker thread: the status is reported by await_resume on the awaiting one
+        void run() {
+            if constexpr (Open) {
+                status = ChaCha20_Poly1305::try_decrypt(c, input, length, aad, aad_len, tag_in, output);
+            }
+            else {
+                status = ChaCha20_Poly1305::try_encrypt(c, input, length, aad, aad_len, output, tag_out);
+            }
+        }
+    };
+
+    // co_await async_seal(...) -> void
+    template <ResumeExecutor Executor>
+    AeadOperation<Executor, false> async_seal(
+        Executor& executor, ChaCha20& c,
+        const uint8_t* plaintext, size_t plaintext_len,
+        const uint8_t* aad, size_t aad_len,
+        uint8_t* output, uint8_t* tag,
+        CryptoWorkerPool& pool = CryptoWorkerPool::shared())
+    {
+        return { executor, pool, c, plaintext, plaintext_len, aad, aad_len, output, tag, nullptr };
+    }
+
+    // co_await async_open(...) -> bool (false when authentication fails)
+    template <ResumeExecutor Executor>
+    AeadOperation<Executor, true> async_open(
+        Executor& executor, ChaCha20& c,
+        const uint8_t* ciphertext, size_t ciphertext_len,
+        const uint8_t* aad, size_t aad_len,
+        const uint8_t* received_tag, uint8_t* output,
+        CryptoWorkerPool& pool = CryptoWorkerPool::shared())
+    {
+        return { executor, pool, c, ciphertext, ciphertext_len, aad, aad_len, output, nullptr, received_tag };
+    }
+}
@@ -0,0 +1,290 @@
+#pragma once
+#include <benchmarking/benchmark.hpp>
+#include <async_aead.hpp>
+#include <tuning.hpp>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+// Startup auto-tuner: measures the Tuning thresholds on this CPU with the
+// primitive timing helpers and caches the result per CPU model, so later
+// starts only read a small text file.
+//
+// Cache file: one line per model, "<model>\t<batch>\t<non-temporal>\t<offload>",
+// "off" for a disabled path. Several models can share one file (e.g. a shared home).
+
+namespace Benchmarking {
+	static constexpr const char* TUNING_CACHE_HEADER = "# ChaCha20-Poly1305 tuning cache v1";
+	static constexpr double TUNING_MIN_GAIN = 0.95;  // A path must be 5% faster to be picked
+	static constexpr double OFFLOAD_FACTOR = 4.0;    // Offload once a seal costs this many pool round trips
+	static constexpr size_t OFFLOAD_MIN = 1024;
+	static constexpr size_t OFFLOAD_MAX = 1024 * 1024;
+
+	// CPU brand string plus the compiled vector ISA (the same CPU tunes differently per build)
+	inline std::string cpu_model() {
+		unsigned int regs[12] = { 0 };
+		std::string brand;
+
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuid(info, 0x80000000);
+		if (static_cast<unsigned int>(info[0]) >= 0x80000004) {
+			for (int i = 0; i < 3; i++) {
+				__cpuid(reinterpret_cast<int*>(regs + i * 4), 0x80000002 + i);
+			}
+			brand.assign(reinterpret_cast<const char*>(regs), sizeof(regs));
+		}
+#else
+		if (__get_cpuid_max(0x80000000, nullptr) >= 0x80000004) {
+			for (unsigned int i = 0; i < 3; i++) {
+				__get_cpuid(0x80000002 + i, &regs[i * 4], &regs[i * 4 + 1], &regs[i * 4 + 2], &regs[i * 4 + 3]);
+			}
+			brand.assign(reinterpret_cast<const char*>(regs), sizeof(regs));
+		}
+#endif
+
+		brand = brand.substr(0, brand.find('\0'));
+		size_t first = brand.find_first_not_of(' ');
+		size_t last = brand.find_last_not_of(' ');
+		brand = (first == std::string::npos) ? "unknown-cpu" : brand.substr(first, last - first + 1);
+
+		for (char& ch : brand) {
+			if (ch == '\t' || ch == '\n') ch = ' ';
+		}
+
+#ifdef __AVX2__
+		return brand + " [avx2]";
+#else
+		return brand + " [sse]";
+#endif
+	}
+
+	inline std::string default_tuning_path() {
+		if (const char* path = std::getenv("CHACHA20_TUNING_CACHE")) return path;
+
+#if defined(_WIN32) || defined(_WIN64)
+		if (const char* dir = std::getenv("LOCALAPPDATA")) return std::string(dir) + "\\chacha20-tuning";
+#else
+		if (const char* dir = std::getenv("XDG_CACHE_HOME")) return std::string(dir) + "/chacha20-tuning";
+		if (const char* home = std::getenv("HOME")) return std::string(home) + "/.cache/chacha20-tuning";
+#endif
+
+		return "chacha20-tuning";
+	}
+
+	// Cache file
+
+	inline std::string threshold_to_string(size_t value) {
+		return value == Tuning::DISABLED ? "off" : std::to_string(value);
+	}
+
+	inline bool threshold_from_string(const std::string& text, size_t& value) {
+		if (text == "off") {
+			value = Tuning::DISABLED;
+			return true;
+		}
+
+		char* end = nullptr;
+		unsigned long long parsed = std::strtoull(text.c_str(), &end, 10);
+		if (text.empty() || *end != '\0') return false;
+
+		value = static_cast<size_t>(parsed);
+		return true;
+	}
+
+	// False when the file or the model's entry is missing or malformed
+	inline bool load_tuning(const std::string& path, const std::string& model, Tuning::Config& config) {
+		std::ifstream file(path);
+		std::string line;
+
+		while (std::getline(file, line)) {
+			if (line.empty() || line[0] == '#') continue;
+
+			std::istringstream fields(line);
+			std::string name, batch, non_temporal, offload;
+			if (!std::getline(fields, name, '\t') || name != model) continue;
+
+			std::getline(fields, batch, '\t');
+			std::getline(fields, non_temporal, '\t');
+			std::getline(fields, offload, '\t');
+
+			Tuning::Config parsed;
+			if (threshold_from_string(batch, parsed.batch_threshold) &&
+				threshold_from_string(non_temporal, parsed.non_temporal_threshold) &&
+				threshold_from_string(offload, parsed.offload_threshold)) {
+				config = parsed;
+				return true;
+			}
+
+			return false;
+		}
+
+		return false;
+	}
+
+	// Replaces the model's entry, keeps the others, and swaps the file in with a rename
+	inline bool save_tuning(const std::string& path, const std::string& model, const Tuning::Config& config) {
+		std::vector<std::string> kept;
+		{
+			std::ifstream file(path);
+			std::string line;
+			while (std::getline(file, line)) {
+				if (line.empty() || line[0] == '#') continue;
+				if (line.compare(0, model.size() + 1, model + "\t") == 0) continue;
+				kept.push_back(line);
+			}
+		}
+
+		std::error_code ec;
+		std::filesystem::path target(path);
+		if (target.has_parent_path()) std::filesystem::create_directories(target.parent_path(), ec);
+
+		std::string temp = path + ".tmp";
+		{
+			std::ofstream out(temp, std::ios::trunc);
+			if (!out) return false;
+
+			out << TUNING_CACHE_HEADER << "\n";
+			for (const std::string& line : kept) out << line << "\n";
+			out << model << "\t" << threshold_to_string(config.batch_threshold)
+				<< "\t" << threshold_to_string(config.non_temporal_threshold)
+				<< "\t" << threshold_to_string(config.offload_threshold) << "\n";
+
+			if (!out.flush()) return false;
+		}
+
+		std::filesystem::rename(temp, target, ec);
+		return !ec;
+	}
+
+	// Calibration
+
+	// Smallest size from which `faster` wins at every larger measured size, or DISABLED
+	inline size_t crossover(const std::vector<size_t>& sizes, const std::vector<bool>& faster) {
+		size_t threshold = Tuning::DISABLED;
+
+		for (size_t i = sizes.size(); i-- > 0;) {
+			if (!faster[i]) break;
+			threshold = sizes[i];
+		}
+
+		return threshold;
+	}
+
+	inline size_t calibrate_batch_threshold(ChaCha20& c, uint8_t* input, uint8_t* output) {
+		const Tuning::Config saved = Tuning::current();
+		std::vector<size_t> sizes;
+		std::vector<bool> faster;
+
+		for (size_t size = 64; size <= 4096; size *= 2) {
+			Tuning::Config config = saved;
+
+			config.batch_threshold = Tuning::DISABLED;
+			Tuning::apply(config);
+			double scalar = measure_cycles_per_call([&] { c.process(input, output, size); }, 1000);
+
+			config.batch_threshold = 0;
+			Tuning::apply(config);
+			double batched = measure_cycles_per_call([&] { c.process(input, output, size); }, 1000);
+
+			sizes.push_back(size);
+			faster.push_back(batched < scalar * TUNING_MIN_GAIN);
+		}
+
+		Tuning::apply(saved);
+		return crossover(sizes, faster);
+	}
+
+	inline size_t calibrate_non_temporal_threshold(ChaCha20& c, uint8_t* input, uint8_t* output, size_t max_size) {
+		std::vector<size_t> sizes;
+		std::vector<bool> faster;
+
+		for (size_t size = 256 * 1024; size <= max_size; size *= 2) {
+			c.set_non_temporal_threshold(ChaCha20::NON_TEMPORAL_DISABLED);
+			double regular = measure_cycles_per_call([&] { c.process(input, output, size); }, 1);
+
+			c.set_non_temporal_threshold(0);
+			double streamed = measure_cycles_per_call([&] { c.process(input, output, size); }, 1);
+
+			sizes.push_back(size);
+			faster.push_back(streamed < regular * TUNING_MIN_GAIN);
+		}
+
+		c.set_non_temporal_threshold(ChaCha20::NON_TEMPORAL_DISABLED);
+		return crossover(sizes, faster);
+	}
+
+	inline size_t calibrate_offload_threshold(ChaCha20& c, uint8_t* input, uint8_t* output) {
+		// Submit-to-completion latency of one empty job on a dedicated worker
+		AsyncAEAD::CryptoWorkerPool pool(1);
+		std::atomic<bool> done{ false };
+
+		double round_trip = measure_cycles_per_call([&] {
+			done.store(false, std::memory_order_relaxed);
+			if (!pool.try_submit([&done] { done.store(true, std::memory_order_release); })) return;
+			while (!done.load(std::memory_order_acquire)) _mm_pause();
+		}, 100);
+
+		uint8_t tag[16];
+		for (size_t size = OFFLOAD_MIN; size <= OFFLOAD_MAX; size *= 2) {
+			double seal = measure_cycles_per_call([&] { ChaCha20_Poly1305::encrypt(c, input, size, nullptr, 0, output, tag); }, 4);
+			if (seal >= OFFLOAD_FACTOR * round_trip) return size;
+		}
+
+		return OFFLOAD_MAX;
+	}
+
+	// Measures every threshold (a few seconds); does not install the result
+	inline Tuning::Config calibrate(size_t max_non_temporal_size = 32 * 1024 * 1024) {
+		uint32_t key[8] = { 0x03020100, 0x07060504, 0x0b0a0908, 0x0f0e0d0c, 0x13121110, 0x17161514, 0x1b1a1918, 0x1f1e1d1c };
+		uint32_t nonce[3] = { 0, 0x4a000000, 0 };
+		ChaCha20 c(key, nonce);
+
+		CryptoHelper::buffer_vector<uint8_t> input(max_non_temporal_size, 0xAA);
+		CryptoHelper::buffer_vector<uint8_t> output(max_non_temporal_size);
+		escape(input.data());
+		escape(output.data());
+
+		Tuning::Config config;
+		config.batch_threshold = calibrate_batch_threshold(c, input.data(), output.data());
+		config.non_temporal_threshold = calibrate_non_temporal_threshold(c, input.data(), output.data(), max_non_temporal_size);
+		config.offload_threshold = calibrate_offload_threshold(c, input.data(), output.data());
+
+		return config;
+	}
+
+	inline void print_tuning(const std::string& model, const Tuning::Config& config, bool cached) {
+		std::cout << "Tuning for " << model << (cached ? " (cached)" : " (measured)") << std::endl;
+		std::cout << "  batch keystream from:  " << threshold_to_string(config.batch_threshold) << std::endl;
+		std::cout << "  non-temporal from:     " << threshold_to_string(config.non_temporal_threshold) << std::endl;
+		std::cout << "  worker offload from:   " << threshold_to_string(config.offload_threshold) << std::endl;
+	}
+
+	// Loads this CPU's entry from the cache (or calibrates and stores it) and applies it.
+	// Call once at startup, before creating ChaCha20 objects.
+	inline Tuning::Config load_or_calibrate(const std::string& path = default_tuning_path(), bool verbose = false) {
+		const std::string model = cpu_model();
+		Tuning::Config config;
+		bool cached = load_tuning(path, model, config);
+
+		if (!cached) {
+			config = calibrate();
+			if (!save_tuning(path, model, config) && verbose) {
+				std::cerr << "Could not write tuning cache " << path << std::endl;
+			}
+		}
+
+		Tuning::apply(config);
+
+		if (verbose) print_tuning(model, config, cached);
+		return config;
+	}
+}
@@ -1,9 +1,17 @@
 ﻿#pragma once
+#include <algorithm>
 #include <chrono>
 #include <limits>
 #include <numeric>
+#include <iomanip>
+#include <bit>
+#include <cmath>
 #include <chacha20_poly1305.hpp>
 #include <thread>
+#include <fstream>
+#include <filesystem>
+#include <sstream>
+#include <cstdlib>
 
 #if defined(_WIN32) || defined(_WIN64)
 #include <Windows.h>
@@ -11,27 +19,364 @@
 #include <sched.h>
 #endif
 
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
 namespace Benchmarking {
-	void set_high_priority() {
+	inline uint64_t read_cycles() {
+		_mm_lfence();
+		unsigned int ui;
+		return __rdtscp(&ui);
+	}
+
+	// Run environment
+	//
+	// The TSC ticks at a fixed reference rate, so raw TSC "cycles" per byte only
+	// compare across machines once converted with the calibrated TSC frequency.
+	// Core cycles come from perf_event where the kernel allows it, energy from RAPL.
+
+	struct BenchmarkConfig {
+		std::vector<int> cpus;      // Empty: the highest-numbered CPU this process may use
+		int realtime_priority = 0;  // SCHED_FIFO priority (1-99), 0 keeps the normal scheduler
+	};
+
+#if defined(_WIN32) || defined(_WIN64)
+	static constexpr int MAX_CPU_ID = 63;                // One affinity mask word
+#elif defined(__linux__) || defined(__GLIBC__)
+	static constexpr int MAX_CPU_ID = CPU_SETSIZE - 1;
+#else
+	static constexpr int MAX_CPU_ID = 0;
+#endif
+
+	// "0,2-4" -> {0, 2, 3, 4}. Malformed items and IDs outside [0, MAX_CPU_ID] are skipped with a warning.
+	inline std::vector<int> parse_cpu_list(const std::string& text) {
+		std::vector<int> cpus;
+		std::stringstream list(text);
+		std::string item;
+
+		// The whole string must be a decimal ID in range
+		auto parse_id = [](const std::string& digits, int& id) {
+			if (digits.empty() || digits.size() > 9 || digits.find_first_not_of("0123456789") != std::string::npos) return false;
+			id = std::atoi(digits.c_str());
+			return id <= MAX_CPU_ID;
+		};
+
+		while (std::getline(list, item, ',')) {
+			if (item.empty()) continue;
+
+			size_t dash = item.find('-');
+			int first = 0, last = 0;
+			bool valid = parse_id(item.substr(0, dash), first) &&
+				(dash == std::string::npos ? (last = first, true) : parse_id(item.substr(dash + 1), last)) &&
+				first <= last;
+
+			if (!valid) {
+				std::cerr << "Warning: ignoring CPU list item \"" << item << "\" (expected an ID or first-last within 0-" << MAX_CPU_ID << ")" << std::endl;
+				continue;
+			}
+
+			for (int cpu = first; cpu <= last; cpu++) cpus.push_back(cpu);
+		}
+
+		return cpus;
+	}
+
+	// CHACHA20_BENCH_CPUS="2,3" and CHACHA20_BENCH_FIFO=<priority>
+	inline BenchmarkConfig benchmark_config_from_env() {
+		BenchmarkConfig config;
+
+		if (const char* cpus = std::getenv("CHACHA20_BENCH_CPUS")) config.cpus = parse_cpu_list(cpus);
+		if (const char* fifo = std::getenv("CHACHA20_BENCH_FIFO")) config.realtime_priority = std::atoi(fifo);
+
+		return config;
+	}
+
+	// CPU 0 usually takes most interrupts, so the default is the last allowed CPU
+	inline int default_benchmark_cpu() {
+#if defined(_WIN32) || defined(_WIN64)
+		DWORD_PTR process_mask = 0, system_mask = 0;
+		GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask);
+		return process_mask ? 63 - std::countl_zero(static_cast<uint64_t>(process_mask)) : 0;
+#elif defined(__linux__) || defined(__GLIBC__)
+		cpu_set_t allowed;
+		CPU_ZERO(&allowed);
+		if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return 0;
+
+		for (int cpu = CPU_SETSIZE - 1; cpu >= 0; cpu--) {
+			if (CPU_ISSET(cpu, &allowed)) return cpu;
+		}
+		return 0;
+#else
+		return 0;
+#endif
+	}
+
+	// Pins the calling thread and optionally raises it to SCHED_FIFO. False if any part was refused.
+	inline bool set_high_priority(const BenchmarkConfig& config = benchmark_config_from_env()) {
+		std::vector<int> cpus = config.cpus.empty() ? std::vector<int>{ default_benchmark_cpu() } : config.cpus;
+		bool ok = true;
+
 #if defined(_WIN32) || defined(_WIN64)
 		DWORD_PTR cpuset = 0;
 
-		cpuset |= (1ULL << 0);
+		for (int cpu : cpus) {
+			if (cpu >= 0 && cpu < 64) cpuset |= (1ULL << cpu);
+		}
 
 		HANDLE currentThread = GetCurrentThread();
-		SetThreadAffinityMask(currentThread, cpuset);
+		ok = SetThreadAffinityMask(currentThread, cpuset) != 0;
+
+		if (config.realtime_priority > 0) {
+			ok = SetThreadPriority(currentThread, THREAD_PRIORITY_TIME_CRITICAL) && ok;
+		}
 #elif defined(__linux__) || defined(__GLIBC__)
 		cpu_set_t cpuset;
 		CPU_ZERO(&cpuset);
-		CPU_SET(0, &cpuset);
-		pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+		for (int cpu : cpus) {
+			if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &cpuset);
+		}
+		ok = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) == 0;
+
+		if (config.realtime_priority > 0) {
+			// Needs CAP_SYS_NICE or an RLIMIT_RTPRIO allowance; the kernel's RT throttling keeps a spinning benchmark from locking up the CPU
+			sched_param param{};
+			param.sched_priority = std::clamp(config.realtime_priority, sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+			ok = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0 && ok;
+		}
 #endif
+
+		if (!ok) {
+			std::cerr << "Warning: could not apply the requested CPU affinity / realtime priority" << std::endl;
+		}
+
+		return ok;
 	}
 
-	inline uint64_t read_cycles() {
-		_mm_lfence();
-		unsigned int ui;
-		return __rdtscp(&ui);
+	// Measured once against steady_clock (median of 5 x 20 ms)
+	inline double tsc_frequency_hz() {
+		static const double frequency = [] {
+			std::vector<double> samples;
+
+			for (int i = 0; i < 5; i++) {
+				auto start = std::chrono::steady_clock::now();
+				uint64_t start_cycles = read_cycles();
+				while (std::chrono::steady_clock::now() - start < std::chrono::milliseconds(20)) {}
+				uint64_t end_cycles = read_cycles();
+				auto end = std::chrono::steady_clock::now();
+
+				samples.push_back(static_cast<double>(end_cycles - start_cycles) / std::chrono::duration<double>(end - start).count());
+			}
+
+			std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+			return samples[samples.size() / 2];
+		}();
+
+		return frequency;
+	}
+
+	// User-space core clock cycles of the calling thread (perf_event, Linux only)
+	class CoreCycleCounter {
+	public:
+		CoreCycleCounter() {
+#if defined(__linux__)
+			perf_event_attr attr{};
+			attr.type = PERF_TYPE_HARDWARE;
+			attr.size = sizeof(attr);
+			attr.config = PERF_COUNT_HW_CPU_CYCLES;
+			attr.exclude_kernel = 1;
+			attr.exclude_hv = 1;
+
+			fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+		}
+
+		~CoreCycleCounter() {
+#if defined(__linux__)
+			if (fd >= 0) close(fd);
+#endif
+		}
+
+		// False in containers / with perf_event_paranoid too strict / without a PMU
+		bool available() const { return fd >= 0; }
+
+		uint64_t read() const {
+			uint64_t value = 0;
+#if defined(__linux__)
+			if (fd >= 0 && ::read(fd, &value, sizeof(value)) != sizeof(value)) value = 0;
+#endif
+			return value;
+		}
+
+		// One per thread: the counter follows the thread that opened it
+		static CoreCycleCounter& local() {
+			thread_local CoreCycleCounter counter;
+			return counter;
+		}
+
+		CoreCycleCounter(const CoreCycleCounter&) = delete;
+		CoreCycleCounter& operator=(const CoreCycleCounter&) = delete;
+	private:
+		int fd = -1;
+	};
+
+	// Package and DRAM energy from the RAPL powercap interface (Linux only).
+	// AMD Zen reports through the same intel-rapl zones (package only, no DRAM zone).
+	// The counters cover the whole socket: other load on the machine is charged to the run,
+	// and they update about once per millisecond, so time runs well above that.
+	// energy_uj is root-only on most kernels (since 5.10); without access the counter is unavailable.
+	class EnergyCounter {
+	public:
+		static constexpr size_t MAX_DOMAINS = 8;
+
+		struct Reading {
+			uint64_t uj[MAX_DOMAINS] = { 0 };
+		};
+
+		EnergyCounter() {
+#if defined(__linux__)
+			std::error_code ec;
+			for (const auto& entry : std::filesystem::directory_iterator("/sys/class/powercap", ec)) {
+				const std::string zone = entry.path().filename().string();
+				if (zone.rfind("intel-rapl:", 0) != 0 || domain_count == MAX_DOMAINS) continue;
+
+				// package-N zones are top level, dram is a subzone of its package
+				const std::string name = read_line(entry.path() / "name");
+				bool package = name.rfind("package", 0) == 0;
+				if (!package && name != "dram") continue;
+
+				int fd = open((entry.path() / "energy_uj").c_str(), O_RDONLY | O_CLOEXEC);
+				if (fd < 0) continue;
+
+				Domain& d = domains[domain_count];
+				d.fd = fd;
+				d.dram = !package;
+				d.range = std::strtoull(read_line(entry.path() / "max_energy_range_uj").c_str(), nullptr, 10);
+
+				uint64_t probe;
+				if (!read_uj(d, probe)) {
+					close(fd); // Exists but unreadable (not root)
+					continue;
+				}
+
+				domain_count++;
+			}
+#endif
+		}
+
+		~EnergyCounter() {
+#if defined(__linux__)
+			for (size_t i = 0; i < domain_count; i++) close(domains[i].fd);
+#endif
+		}
+
+		bool available() const { return domain_count > 0; }
+
+		bool has_dram() const {
+			for (size_t i = 0; i < domain_count; i++) {
+				if (domains[i].dram) return true;
+			}
+			return false;
+		}
+
+		Reading read() const {
+			Reading r;
+			for (size_t i = 0; i < domain_count; i++) read_uj(domains[i], r.uj[i]);
+			return r;
+		}
+
+		// Joules between two readings summed over all sockets, accounting for counter wrap
+		void joules(const Reading& start, const Reading& end, double& package, double& dram) const {
+			package = dram = 0.0;
+
+			for (size_t i = 0; i < domain_count; i++) {
+				uint64_t delta = end.uj[i] >= start.uj[i] ? end.uj[i] - start.uj[i] : domains[i].range - start.uj[i] + end.uj[i];
+				(domains[i].dram ? dram : package) += static_cast<double>(delta) * 1e-6;
+			}
+		}
+
+		static EnergyCounter& shared() {
+			static EnergyCounter counter;
+			return counter;
+		}
+
+		EnergyCounter(const EnergyCounter&) = delete;
+		EnergyCounter& operator=(const EnergyCounter&) = delete;
+	private:
+		struct Domain {
+			int fd = -1;
+			bool dram = false;
+			uint64_t range = 0;
+		};
+
+		Domain domains[MAX_DOMAINS];
+		size_t domain_count = 0;
+
+		static bool read_uj(const Domain& d, uint64_t& value) {
+#if defined(__linux__)
+			char text[32];
+			ssize_t n = pread(d.fd, text, sizeof(text) - 1, 0);
+			if (n <= 0) return false;
+
+			text[n] = '\0';
+			value = std::strtoull(text, nullptr, 10);
+			return true;
+#else
+			(void)d;
+			(void)value;
+			return false;
+#endif
+		}
+
+		static std::string read_line(const std::filesystem::path& path) {
+			std::ifstream file(path);
+			std::string line;
+			std::getline(file, line);
+			return line;
+		}
+	};
+
+	inline std::string read_sysfs(const std::string& path) {
+		std::ifstream file(path);
+		std::string value;
+		std::getline(file, value);
+		return value.empty() ? "unknown" : value;
+	}
+
+	// Governor, turbo and SMT state for the CPUs the benchmark runs on
+	inline void print_environment(const BenchmarkConfig& config = benchmark_config_from_env()) {
+		std::vector<int> cpus = config.cpus.empty() ? std::vector<int>{ default_benchmark_cpu() } : config.cpus;
+
+		std::cout << "\n=======================================================" << std::endl;
+		std::cout << " Benchmark environment" << std::endl;
+		std::cout << "=======================================================" << std::endl;
+		std::cout << std::fixed << std::setprecision(4);
+		std::cout << std::left << std::setw(25) << "  TSC frequency:" << std::right << std::setw(15) << tsc_frequency_hz() / 1e9 << " GHz" << std::endl;
+		std::cout << std::left << std::setw(25) << "  Core cycle counter:" << std::right << std::setw(15) << (CoreCycleCounter::local().available() ? "perf_event" : "unavailable") << std::endl;
+		std::cout << std::left << std::setw(25) << "  RAPL energy:" << std::right << std::setw(15) << (!EnergyCounter::shared().available() ? "unavailable" : EnergyCounter::shared().has_dram() ? "package+dram" : "package") << std::endl;
+		std::cout << std::left << std::setw(25) << "  Realtime priority:" << std::right << std::setw(15) << (config.realtime_priority > 0 ? "SCHED_FIFO " + std::to_string(config.realtime_priority) : std::string("off")) << std::endl;
+
+#if defined(__linux__)
+		const std::string sys = "/sys/devices/system/cpu/";
+		std::cout << std::left << std::setw(25) << "  SMT active:" << std::right << std::setw(15) << read_sysfs(sys + "smt/active") << std::endl;
+		std::cout << std::left << std::setw(25) << "  Turbo disabled:" << std::right << std::setw(15) << read_sysfs(sys + "intel_pstate/no_turbo") << std::endl;
+
+		for (int cpu : cpus) {
+			const std::string dir = sys + "cpu" + std::to_string(cpu) + "/";
+			std::cout << "  CPU " << cpu
+				<< ": governor " << read_sysfs(dir + "cpufreq/scaling_governor")
+				<< ", siblings " << read_sysfs(dir + "topology/thread_siblings_list") << std::endl;
+		}
+
+		std::cout << "  (pinning to a CPU whose SMT sibling is busy, or a non-performance governor, skews results)" << std::endl;
+#else
+		for (int cpu : cpus) std::cout << "  CPU " << cpu << std::endl;
+#endif
+
+		std::cout << "=======================================================\n" << std::endl;
 	}
 
 	struct PerformanceResults {
@@ -40,7 +385,15 @@ namespace Benchmarking {
 		double worst_throughput = std::numeric_limits<double>::max();
 		double throughput_amplitude = 0.0;
 		double throughput_iqr = 0.0;
-		double average_cpb = 0.0;
+		double average_cpb = 0.0;        // TSC (reference) cycles per byte
+		double average_core_cpb = 0.0;   // Core cycles per byte, 0 without perf_event
+		double average_ns_per_byte = 0.0;
+		double tsc_ghz = 0.0;
+		bool energy_measured = false;          // RAPL counters were readable
+		double package_nj_per_byte = 0.0;      // nJ/B is the same number as J/GB
+		double dram_nj_per_byte = 0.0;         // 0 without a DRAM zone
+		double package_uj_per_message = 0.0;
+		double dram_uj_per_message = 0.0;
 		std::chrono::duration<double> biggest_time = std::chrono::duration<double>::zero();
 		std::chrono::duration<double> smallest_time = std::chrono::duration<double>::max();
 		std::chrono::duration<double> average_time = std::chrono::duration<double>::zero();
@@ -72,7 +425,64 @@ namespace Benchmarking {
 			std::cout << std::left << std::setw(label_w) << "  IQR:" << std::right << std::setw(value_w) << time_iqr.count() << "s" << std::endl;
 
         	std::cout << "[ EFFICIENCY ]" << std::endl;
-        	std::cout << std::left << std::setw(25) << "  Average CPB:" << std::right << std::setw(15) << average_cpb << " c/B" << std::endl;
+        	std::cout << std::left << std::setw(25) << "  Average CPB (TSC):" << std::right << std::setw(15) << average_cpb << " c/B" << std::endl;
+			if (average_core_cpb > 0.0) {
+				std::cout << std::left << std::setw(25) << "  Average CPB (core):" << std::right << std::setw(15) << average_core_cpb << " c/B" << std::endl;
+			}
+			else {
+				std::cout << std::left << std::setw(25) << "  Average CPB (core):" << std::right << std::setw(15) << "n/a" << " (perf_event unavailable)" << std::endl;
+			}
+			std::cout << std::left << std::setw(25) << "  Average ns/B:" << std::right << std::setw(15) << average_ns_per_byte << " ns/B" << std::endl;
+			std::cout << std::left << std::setw(25) << "  TSC frequency:" << std::right << std::setw(15) << tsc_ghz << " GHz" << std::endl;
+
+			std::cout << "[ ENERGY ]" << std::endl;
+			if (energy_measured) {
+				std::cout << std::left << std::setw(25) << "  Package:" << std::right << std::setw(15) << package_nj_per_byte << " nJ/B (J/GB)" << std::endl;
+				std::cout << std::left << std::setw(25) << "  DRAM:" << std::right << std::setw(15) << dram_nj_per_byte << " nJ/B (J/GB)" << std::endl;
+				std::cout << std::left << std::setw(25) << "  Package per message:" << std::right << std::setw(15) << package_uj_per_message << " uJ" << std::endl;
+				std::cout << std::left << std::setw(25) << "  DRAM per message:" << std::right << std::setw(15) << dram_uj_per_message << " uJ" << std::endl;
+			}
+			else {
+				std::cout << std::left << std::setw(25) << "  Package / DRAM:" << std::right << std::setw(15) << "n/a" << " (RAPL unreadable)" << std::endl;
+			}
+			std::cout << "=======================================================\n" << std::endl;
+		}
+
+		// Several runs of the same workload as columns (e.g. warm vs cold cache)
+		static void print_comparison(const std::string title, const std::vector<std::pair<std::string, PerformanceResults>>& columns) {
+			const int label_w = 22;
+			const int value_w = 14;
+
+			std::cout << "\n=======================================================" << std::endl;
+			std::cout << " " << title << std::endl;
+			std::cout << "=======================================================" << std::endl;
+			std::cout << std::fixed << std::setprecision(4);
+
+			std::cout << std::left << std::setw(label_w) << "";
+			for (const auto& [name, r] : columns) std::cout << std::right << std::setw(value_w) << name;
+			std::cout << std::endl;
+
+			auto row = [&](const char* label, auto value) {
+				std::cout << std::left << std::setw(label_w) << label;
+				for (const auto& [name, r] : columns) std::cout << std::right << std::setw(value_w) << value(r);
+				std::cout << std::endl;
+			};
+
+			row("  Avg MB/s", [](const PerformanceResults& r) { return r.average_throughput; });
+			row("  Best MB/s", [](const PerformanceResults& r) { return r.best_throughput; });
+			row("  Worst MB/s", [](const PerformanceResults& r) { return r.worst_throughput; });
+			row("  IQR MB/s", [](const PerformanceResults& r) { return r.throughput_iqr; });
+			row("  Avg time (s)", [](const PerformanceResults& r) { return r.average_time.count(); });
+			row("  CPB (TSC)", [](const PerformanceResults& r) { return r.average_cpb; });
+			row("  CPB (core)", [](const PerformanceResults& r) { return r.average_core_cpb; });
+			row("  ns/B", [](const PerformanceResults& r) { return r.average_ns_per_byte; });
+
+			if (!columns.empty() && columns.front().second.energy_measured) {
+				row("  Pkg nJ/B (J/GB)", [](const PerformanceResults& r) { return r.package_nj_per_byte; });
+				row("  DRAM nJ/B (J/GB)", [](const PerformanceResults& r) { return r.dram_nj_per_byte; });
+				row("  Pkg uJ/message", [](const PerformanceResults& r) { return r.package_uj_per_message; });
+			}
+
 			std::cout << "=======================================================\n" << std::endl;
 		}
 	};
@@ -82,18 +492,37 @@ namespace Benchmarking {
 		std::vector<std::chrono::duration<double>> times;
 		std::vector<double> throughputs;
 		std::vector<uint64_t> total_cycles;
+		std::vector<uint64_t> total_core_cycles;
+		double package_joules = 0.0;
+		double dram_joules = 0.0;
+		size_t energy_runs = 0;
 		double bytes_per_run;
+		double messages_per_run;
 	public:
-		PerformanceMetric(size_t reserve_size, double bytes_): bytes_per_run(bytes_) {
+		PerformanceMetric(size_t reserve_size, double bytes_, double messages_ = 1.0): bytes_per_run(bytes_), messages_per_run(messages_) {
 			times.reserve(reserve_size);
 			throughputs.reserve(reserve_size);
 			total_cycles.reserve(reserve_size);
+			total_core_cycles.reserve(reserve_size);
 		}
 
-		void pushMetrics(std::chrono::duration<double> time, double throughput, double cpb) {
+		// core_cycles = 0 when no core cycle counter is available
+		void pushMetrics(std::chrono::duration<double> time, double throughput, uint64_t cycles, uint64_t core_cycles = 0) {
 			times.push_back(time);
 			throughputs.push_back(throughput);
-			total_cycles.push_back(cpb);
+			total_cycles.push_back(cycles);
+			total_core_cycles.push_back(core_cycles);
+		}
+
+		// Energy of one run; a no-op when the counters are unavailable
+		void pushEnergy(const EnergyCounter& counter, const EnergyCounter::Reading& start, const EnergyCounter::Reading& end) {
+			if (!counter.available()) return;
+
+			double package_j, dram_j;
+			counter.joules(start, end, package_j, dram_j);
+			package_joules += package_j;
+			dram_joules += dram_j;
+			energy_runs++;
 		}
 
 		PerformanceResults finish() {
@@ -134,10 +563,184 @@ namespace Benchmarking {
 			double avg_cycles = std::accumulate(total_cycles.begin(), total_cycles.end(), 0.0) / total_cycles.size();
         	r.average_cpb = avg_cycles / static_cast<double>(bytes_per_run);
 
+			double avg_core_cycles = std::accumulate(total_core_cycles.begin(), total_core_cycles.end(), 0.0) / total_core_cycles.size();
+			r.average_core_cpb = avg_core_cycles / static_cast<double>(bytes_per_run);
+			r.average_ns_per_byte = r.average_time.count() * 1e9 / bytes_per_run;
+			r.tsc_ghz = tsc_frequency_hz() / 1e9;
+
+			if (energy_runs) {
+				const double runs = static_cast<double>(energy_runs);
+				r.energy_measured = true;
+				r.package_nj_per_byte = package_joules / runs / bytes_per_run * 1e9;
+				r.dram_nj_per_byte = dram_joules / runs / bytes_per_run * 1e9;
+				r.package_uj_per_message = package_joules / runs / messages_per_run * 1e6;
+				r.dram_uj_per_message = dram_joules / runs / messages_per_run * 1e6;
+			}
+
 			return r;
 		}
 	};
 
+	// Log-bucketed latency histogram (HDR style): exact below 32, then 32 linear
+	// sub-buckets per power of two, so any recorded value is within ~3%
+
+	struct LatencyHistogram {
+		static constexpr int SUB_BUCKET_BITS = 5;
+		static constexpr uint64_t SUB_BUCKETS = 1ULL << SUB_BUCKET_BITS;
+
+		std::vector<uint64_t> counts = std::vector<uint64_t>(64 * SUB_BUCKETS, 0);
+		uint64_t total = 0;
+		uint64_t max_value = 0;
+
+		static size_t bucket_index(uint64_t value) {
+			if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+
+			int shift = (63 - std::countl_zero(value)) - SUB_BUCKET_BITS;
+			return static_cast<size_t>(shift * SUB_BUCKETS + (value >> shift));
+		}
+
+		// Highest value that maps to the bucket
+		static uint64_t bucket_value(size_t index) {
+			if (index < SUB_BUCKETS) return index;
+
+			int shift = static_cast<int>(index / SUB_BUCKETS) - 1;
+			uint64_t mantissa = index - shift * SUB_BUCKETS;
+			return (mantissa << shift) + ((1ULL << shift) - 1);
+		}
+
+		void record(uint64_t value) {
+			counts[bucket_index(value)]++;
+			total++;
+			if (value > max_value) max_value = value;
+		}
+
+		uint64_t percentile(double p) const {
+			if (total == 0) return 0;
+
+			uint64_t target = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total)));
+			if (target == 0) target = 1;
+
+			uint64_t seen = 0;
+			for (size_t i = 0; i < counts.size(); i++) {
+				seen += counts[i];
+				if (seen >= target) return min_(bucket_value(i), max_value);
+			}
+
+			return max_value;
+		}
+	};
+
+	struct LatencyResults {
+		size_t message_size = 0;
+		double target_rate = 0.0; // ops/s, 0 = closed loop
+		LatencyHistogram ns;
+		LatencyHistogram cycles;
+
+		void print(const std::string title) const {
+			const int label_w = 25;
+			const int value_w = 15;
+			const std::pair<const char*, double> rows[] = {
+				{ "  p50:", 50.0 }, { "  p90:", 90.0 }, { "  p99:", 99.0 }, { "  p99.9:", 99.9 }
+			};
+
+			std::cout << "\n=======================================================" << std::endl;
+			std::cout << " " << title << " (" << message_size << " B, ";
+			if (target_rate > 0.0) std::cout << "open loop @ " << target_rate << " ops/s)" << std::endl;
+			else std::cout << "closed loop)" << std::endl;
+			std::cout << "=======================================================" << std::endl;
+
+			std::cout << "[ LATENCY (ns) ]" << std::endl;
+			for (auto& [label, p] : rows) {
+				std::cout << std::left << std::setw(label_w) << label << std::right << std::setw(value_w) << ns.percentile(p) << "ns" << std::endl;
+			}
+			std::cout << std::left << std::setw(label_w) << "  Max:" << std::right << std::setw(value_w) << ns.max_value << "ns" << std::endl;
+
+			std::cout << "\n[ SERVICE TIME (cycles) ]" << std::endl;
+			for (auto& [label, p] : rows) {
+				std::cout << std::left << std::setw(label_w) << label << std::right << std::setw(value_w) << cycles.percentile(p) << "c" << std::endl;
+			}
+			std::cout << std::left << std::setw(label_w) << "  Max:" << std::right << std::setw(value_w) << cycles.max_value << "c" << std::endl;
+			std::cout << std::left << std::setw(label_w) << "  Samples:" << std::right << std::setw(value_w) << ns.total << std::endl;
+			std::cout << "=======================================================\n" << std::endl;
+		}
+	};
+
+	static size_t constexpr LATENCY_ITERATIONS = 1000000;
+	static size_t constexpr LATENCY_WARMUP_ITERATIONS = 10000;
+	static size_t constexpr LATENCY_SIZES[] = { 16, 64, 256, 1024, 4096 };
+
+	// Times every call individually. With a target rate, calls follow a fixed
+	// schedule and latency is measured from the intended start, so a stall is
+	// charged to every call queued behind it (coordinated-omission safe).
+	template <typename Op>
+	inline void run_latency_test(const size_t iterations, const double target_rate, LatencyResults& results, Op&& op) {
+		using clock = std::chrono::steady_clock;
+
+		const auto interval = target_rate > 0.0
+			? std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / target_rate))
+			: clock::duration::zero();
+		const auto schedule_start = clock::now();
+
+		for (size_t i = 0; i < iterations; i++) {
+			auto intended = schedule_start + interval * static_cast<int64_t>(i);
+			if (target_rate > 0.0) {
+				while (clock::now() < intended) {} // Spin: sleeping would add wake-up jitter
+			}
+
+			auto start = clock::now();
+			uint64_t start_cycles = read_cycles();
+
+			op();
+
+			uint64_t end_cycles = read_cycles();
+			auto end = clock::now();
+
+			auto from = target_rate > 0.0 ? intended : start;
+			results.ns.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - from).count()));
+			results.cycles.record(end_cycles - start_cycles);
+		}
+	}
+
+	inline void test_latency(double target_rate = 0.0, size_t iterations = LATENCY_ITERATIONS) {
+		uint32_t key[8] = {
+			0xa9, 0xf1, 0xb3, 0x39,
+			0x04, 0xff, 0xa1, 0xb7
+		};
+
+		uint32_t nonce[3] = { 0xe5, 0xa3, 0x88 };
+
+		ChaCha20 test(key, nonce);
+
+		for (size_t size : LATENCY_SIZES) {
+			std::vector<uint8_t> plaintext(size, 0xAA);
+			std::vector<uint8_t> ciphertext(size);
+			std::vector<uint8_t> decrypted(size);
+			std::vector<uint8_t> aad(16, 0x03);
+			uint8_t tag[16];
+
+			auto seal = [&] { ChaCha20_Poly1305::encrypt(test, plaintext.data(), size, aad.data(), aad.size(), ciphertext.data(), tag); };
+			auto open = [&] { ChaCha20_Poly1305::decrypt(test, ciphertext.data(), size, aad.data(), aad.size(), tag, decrypted.data()); };
+
+			for (size_t i = 0; i < LATENCY_WARMUP_ITERATIONS; i++) {
+				seal();
+				open();
+			}
+
+			LatencyResults seal_res;
+			seal_res.message_size = size;
+			seal_res.target_rate = target_rate;
+			run_latency_test(iterations, target_rate, seal_res, seal);
+
+			LatencyResults open_res;
+			open_res.message_size = size;
+			open_res.target_rate = target_rate;
+			run_latency_test(iterations, target_rate, open_res, open);
+
+			seal_res.print("ChaCha20-Poly1305 seal latency");
+			open_res.print("ChaCha20-Poly1305 open latency");
+		}
+	}
+
 	static size_t constexpr WARMUP_ITERATIONS = 30;
 	static size_t constexpr WARMUP_DATA_SIZE = 1024 * 1024 * 10; // 5 MB
 
@@ -147,18 +750,25 @@ namespace Benchmarking {
 	static size_t constexpr KB = 1024;
 
 	void run_chacha20_tests(const size_t data_size, const size_t rounds, PerformanceMetric& metrics, ChaCha20& test, bool verbose=false) {
-		std::vector<uint8_t> plaintext(data_size, 0xAA);
-		std::vector<uint8_t> ciphertext(data_size);
+		CryptoHelper::buffer_vector<uint8_t> plaintext(data_size, 0xAA);
+		CryptoHelper::buffer_vector<uint8_t> ciphertext(data_size);
+		CoreCycleCounter& core = CoreCycleCounter::local();
+		EnergyCounter& energy = EnergyCounter::shared();
+
 		for (size_t i = 0; i < rounds; i++) {
 			test.set_counter(0);
 
+			EnergyCounter::Reading start_energy = energy.read();
+			uint64_t start_core = core.read();
 			uint64_t start_cycles = read_cycles();
 
 			auto start = std::chrono::steady_clock::now();
 			test.process(plaintext.data(), ciphertext.data(), data_size);
 
-			uint64_t end_cycles = read_cycles();;
+			uint64_t end_cycles = read_cycles();
         	auto end = std::chrono::steady_clock::now();
+			uint64_t core_cycles = core.read() - start_core;
+			EnergyCounter::Reading end_energy = energy.read();
 
 			std::chrono::duration<double> duration = end - start;
 			uint64_t total_cycles = end_cycles - start_cycles;
@@ -173,20 +783,26 @@ namespace Benchmarking {
 				std::cout << "========================================" << std::endl;
 			}
 
-			metrics.pushMetrics(duration, throughput_mbps, total_cycles);
+			metrics.pushMetrics(duration, throughput_mbps, total_cycles, core_cycles);
+			metrics.pushEnergy(energy, start_energy, end_energy);
 		}
 	}
 
 	void run_chacha_aead_tests(const size_t data_size, const size_t rounds, PerformanceMetric& enc_metrics, PerformanceMetric& dec_metrics, ChaCha20& test, bool verbose=false) {
-		std::vector<uint8_t> plaintext(data_size, 0xAA);
-		std::vector<uint8_t> ciphertext(data_size);
+		CryptoHelper::buffer_vector<uint8_t> plaintext(data_size, 0xAA);
+		CryptoHelper::buffer_vector<uint8_t> ciphertext(data_size);
 		std::vector<uint8_t> aad(16, 0x03);
 		uint8_t tag[16];
 
+		CoreCycleCounter& core = CoreCycleCounter::local();
+		EnergyCounter& energy = EnergyCounter::shared();
+
 		for (size_t i = 0; i < rounds; i++) {
 			if(verbose) std::cout << "\nTest " << (i + 1) << "\n" << std::endl;
 
 			// --- ENCRYPTION ---
+			EnergyCounter::Reading start_energy = energy.read();
+			uint64_t start_core = core.read();
 			uint64_t start_cycles = read_cycles();
 			auto start = std::chrono::steady_clock::now();
 
@@ -194,6 +810,8 @@ namespace Benchmarking {
 
 			uint64_t end_cycles = read_cycles();
 			auto end = std::chrono::steady_clock::now();
+			uint64_t core_cycles = core.read() - start_core;
+			EnergyCounter::Reading end_energy = energy.read();
 
 			uint64_t diff_cycles = end_cycles - start_cycles;
 			std::chrono::duration<double> duration = end - start;
@@ -207,9 +825,12 @@ namespace Benchmarking {
 				std::cout << "CPB: " << cpb << " cycles/byte\n" << std::endl;
 			}
 			
-			enc_metrics.pushMetrics(duration, throughput_mbps, diff_cycles);
+			enc_metrics.pushMetrics(duration, throughput_mbps, diff_cycles, core_cycles);
+			enc_metrics.pushEnergy(energy, start_energy, end_energy);
 
 			// --- DECRYPTION ---
+			start_energy = energy.read();
+			start_core = core.read();
 			start_cycles = read_cycles();
 			start = std::chrono::steady_clock::now();
 
@@ -217,6 +838,8 @@ namespace Benchmarking {
 
 			end_cycles = read_cycles();
 			end = std::chrono::steady_clock::now();
+			core_cycles = core.read() - start_core;
+			end_energy = energy.read();
 
 			diff_cycles = end_cycles - start_cycles;
 			duration = end - start;
@@ -231,7 +854,8 @@ namespace Benchmarking {
 				std::cout << "========================================" << std::endl;
 			}
 
-			dec_metrics.pushMetrics(duration, throughput_mbps, diff_cycles);
+			dec_metrics.pushMetrics(duration, throughput_mbps, diff_cycles, core_cycles);
+			dec_metrics.pushEnergy(energy, start_energy, end_energy);
 		}
 	}
 
@@ -293,18 +917,15 @@ namespace Benchmarking {
 
 		ChaCha20 test(key, nonce);
 
-		uint8_t* warm_in = new uint8_t[WARMUP_DATA_SIZE];
-		uint8_t* warm_out = new uint8_t[WARMUP_DATA_SIZE];
-
-		std::memset(warm_in, 0xAA, WARMUP_DATA_SIZE);
+		{
+			CryptoHelper::buffer_vector<uint8_t> warm_in(WARMUP_DATA_SIZE, 0xAA);
+			CryptoHelper::buffer_vector<uint8_t> warm_out(WARMUP_DATA_SIZE);
 
-		for (size_t i = 0; i < WARMUP_ITERATIONS; i++) {
-			test.process(warm_in, warm_out, WARMUP_DATA_SIZE);
+			for (size_t i = 0; i < WARMUP_ITERATIONS; i++) {
+				test.process(warm_in.data(), warm_out.data(), WARMUP_DATA_SIZE);
+			}
 		}
 
-		delete[] warm_in;
-		delete[] warm_out;
-
 		std::cout << "Warmup done" << std::endl;
 
 		PerformanceMetric metric(TEST_ITERATIONS, TEST_DATA_SIZE);
@@ -330,8 +951,8 @@ namespace Benchmarking {
 
 		{
 
-			std::vector<uint8_t> warm_in(WARMUP_DATA_SIZE, 0xAA);
-			std::vector<uint8_t> warm_out(WARMUP_DATA_SIZE);
+			CryptoHelper::buffer_vector<uint8_t> warm_in(WARMUP_DATA_SIZE, 0xAA);
+			CryptoHelper::buffer_vector<uint8_t> warm_out(WARMUP_DATA_SIZE);
 			std::vector<uint8_t> aad(KB, 0xF8); // 1 KB
 			uint8_t tag[16];
 
@@ -354,4 +975,436 @@ namespace Benchmarking {
 
 		test_chacha20poly1305_correctness(test);
 	}
+
+	// Cache modes
+	//
+	// Warm:       the same buffers every iteration (what test_chacha20/test_aead measure)
+	// Flushed:    clflush over input and output before every iteration
+	// Rotating:   cycle through enough buffer pairs to exceed twice the LLC
+	// FirstTouch: input flushed, output on never-touched 4 KiB pages (page faults land in the timed region)
+
+	enum class CacheMode { Warm, Flushed, Rotating, FirstTouch };
+
+	inline const char* cache_mode_name(CacheMode mode) {
+		switch (mode) {
+		case CacheMode::Warm: return "warm";
+		case CacheMode::Flushed: return "flushed";
+		case CacheMode::Rotating: return "rotating";
+		case CacheMode::FirstTouch: return "first touch";
+		}
+		return "?";
+	}
+
+	static size_t constexpr DEFAULT_LLC_SIZE = 32 * 1024 * 1024;
+	static size_t constexpr PAGE_FAULT_PROBE_SIZE = 64 * 1024 * 1024;
+	static size_t constexpr ROTATING_MAX_BYTES = 1024ULL * 1024 * 1024; // Cap for machines reporting huge LLCs
+
+	inline size_t llc_size_bytes() {
+#if defined(__linux__)
+		long size = sysconf(_SC_LEVEL3_CACHE_SIZE);
+		if (size > 0) return static_cast<size_t>(size);
+
+		// sysconf reports 0 on some libcs / CPUs, sysfs reads e.g. "32768K"
+		std::string text = read_sysfs("/sys/devices/system/cpu/cpu0/cache/index3/size");
+		char* end = nullptr;
+		unsigned long long value = std::strtoull(text.c_str(), &end, 10);
+		if (value > 0) {
+			if (*end == 'K') value *= 1024;
+			else if (*end == 'M') value *= 1024 * 1024;
+			return static_cast<size_t>(value);
+		}
+#endif
+		return DEFAULT_LLC_SIZE;
+	}
+
+	inline void flush_buffer(const void* ptr, size_t length) {
+		const uint8_t* bytes = static_cast<const uint8_t*>(ptr);
+
+		for (size_t offset = 0; offset < length; offset += 64) {
+			_mm_clflush(bytes + offset);
+		}
+		_mm_mfence();
+	}
+
+	// Anonymous 4 KiB pages that were never touched (malloc would hand back recycled, already faulted memory)
+	inline uint8_t* map_fresh_pages(size_t length) {
+#if defined(__linux__)
+		void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (ptr == MAP_FAILED) throw std::bad_alloc();
+		madvise(ptr, length, MADV_NOHUGEPAGE);
+		return static_cast<uint8_t*>(ptr);
+#else
+		return static_cast<uint8_t*>(CryptoHelper::alloc_buffer(length, CryptoHelper::BUFFER_DEFAULT));
+#endif
+	}
+
+	inline void unmap_fresh_pages(uint8_t* ptr, size_t length) {
+#if defined(__linux__)
+		munmap(ptr, length);
+#else
+		CryptoHelper::free_buffer(ptr, length, CryptoHelper::BUFFER_DEFAULT);
+#endif
+	}
+
+	// op(input, output) runs one iteration over data_size bytes
+	template <typename Op>
+	inline void run_cache_mode_tests(CacheMode mode, const size_t data_size, const size_t rounds, PerformanceMetric& metrics, Op&& op) {
+		size_t sets = 1;
+		if (mode == CacheMode::Rotating) {
+			sets = (2 * llc_size_bytes() + 2 * data_size - 1) / (2 * data_size) + 1;
+			sets = std::clamp<size_t>(sets, 2, std::max<size_t>(2, ROTATING_MAX_BYTES / (2 * data_size)));
+		}
+
+		std::vector<CryptoHelper::buffer_vector<uint8_t>> inputs, outputs;
+		for (size_t i = 0; i < sets; i++) {
+			inputs.emplace_back(data_size, 0xAA);
+			outputs.emplace_back(data_size, 0x00);
+		}
+
+		CoreCycleCounter& core = CoreCycleCounter::local();
+		EnergyCounter& energy = EnergyCounter::shared();
+
+		for (size_t i = 0; i < rounds; i++) {
+			uint8_t* input = inputs[i % sets].data();
+			uint8_t* output = outputs[i % sets].data();
+
+			if (mode == CacheMode::Flushed || mode == CacheMode::FirstTouch) {
+				flush_buffer(input, data_size);
+				flush_buffer(output, data_size);
+			}
+
+			if (mode == CacheMode::FirstTouch) {
+				output = map_fresh_pages(data_size);
+			}
+
+			EnergyCounter::Reading start_energy = energy.read();
+			uint64_t start_core = core.read();
+			uint64_t start_cycles = read_cycles();
+			auto start = std::chrono::steady_clock::now();
+
+			op(input, output);
+
+			uint64_t end_cycles = read_cycles();
+			auto end = std::chrono::steady_clock::now();
+			uint64_t core_cycles = core.read() - start_core;
+			EnergyCounter::Reading end_energy = energy.read();
+
+			if (mode == CacheMode::FirstTouch) {
+				unmap_fresh_pages(output, data_size);
+			}
+
+			std::chrono::duration<double> duration = end - start;
+			double throughput_mbps = (data_size / (1024.0 * 1024.0)) / duration.count();
+			metrics.pushMetrics(duration, throughput_mbps, end_cycles - start_cycles, core_cycles);
+			metrics.pushEnergy(energy, start_energy, end_energy);
+		}
+	}
+
+	// Cost of the first write to a fresh anonymous 4 KiB page (fault + zeroing), in ns
+	inline double page_fault_ns() {
+		const size_t page = 4096;
+		std::vector<double> samples;
+
+		for (int t = 0; t < 5; t++) {
+			uint8_t* fresh = map_fresh_pages(PAGE_FAULT_PROBE_SIZE);
+			volatile uint8_t* bytes = fresh;
+
+			auto start = std::chrono::steady_clock::now();
+			for (size_t offset = 0; offset < PAGE_FAULT_PROBE_SIZE; offset += page) {
+				bytes[offset] = 1;
+			}
+			auto end = std::chrono::steady_clock::now();
+
+			unmap_fresh_pages(fresh, PAGE_FAULT_PROBE_SIZE);
+			samples.push_back(std::chrono::duration<double, std::nano>(end - start).count() / (PAGE_FAULT_PROBE_SIZE / page));
+		}
+
+		std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+		return samples[samples.size() / 2];
+	}
+
+	inline void test_cache_modes(size_t data_size = TEST_DATA_SIZE, size_t iterations = TEST_ITERATIONS) {
+		uint32_t key[8] = {
+			0xa9, 0xf1, 0xb3, 0x39,
+			0x04, 0xff, 0xa1, 0xb7
+		};
+
+		uint32_t nonce[3] = { 0xe5, 0xa3, 0x88 };
+
+		ChaCha20 test(key, nonce);
+		std::vector<uint8_t> aad(16, 0x03);
+		uint8_t tag[16];
+
+		const CacheMode modes[] = { CacheMode::Warm, CacheMode::Flushed, CacheMode::Rotating, CacheMode::FirstTouch };
+		std::vector<std::pair<std::string, PerformanceResults>> cipher_columns, aead_columns;
+
+		for (CacheMode mode : modes) {
+			PerformanceMetric cipher_metric(iterations, static_cast<double>(data_size));
+			run_cache_mode_tests(mode, data_size, iterations, cipher_metric, [&](const uint8_t* in, uint8_t* out) {
+				test.set_counter(0);
+				test.process(in, out, data_size);
+			});
+			cipher_columns.emplace_back(cache_mode_name(mode), cipher_metric.finish());
+
+			PerformanceMetric aead_metric(iterations, static_cast<double>(data_size));
+			run_cache_mode_tests(mode, data_size, iterations, aead_metric, [&](const uint8_t* in, uint8_t* out) {
+				ChaCha20_Poly1305::encrypt(test, in, data_size, aad.data(), aad.size(), out, tag);
+			});
+			aead_columns.emplace_back(cache_mode_name(mode), aead_metric.finish());
+		}
+
+		std::string size_label = " (" + std::to_string(data_size) + " B, LLC " + std::to_string(llc_size_bytes() / 1024) + " KiB)";
+		PerformanceResults::print_comparison("ChaCha20 by cache state" + size_label, cipher_columns);
+		PerformanceResults::print_comparison("ChaCha20-Poly1305 seal by cache state" + size_label, aead_columns);
+
+		std::cout << std::left << std::setw(25) << "  Page fault (4 KiB):" << std::right << std::setw(15) << page_fault_ns() << " ns/page\n" << std::endl;
+	}
+
+	// Energy per byte and per message of the seal path, scalar vs 8-block keystream kernel.
+	// Each sample runs ENERGY_SAMPLE_BYTES of messages so it spans many RAPL updates.
+
+	static constexpr size_t ENERGY_MESSAGE_SIZES[] = { 64, 1024, 16 * 1024, 1024 * 1024 };
+	static constexpr size_t ENERGY_SAMPLE_BYTES = 32 * 1024 * 1024;
+	static constexpr size_t ENERGY_SAMPLES = 5;
+
+	// Times `samples` runs of op() (one message each call) over about sample_bytes per run
+	template <typename Op>
+	inline PerformanceResults measure_messages(size_t message_size, size_t sample_bytes, size_t samples, Op&& op) {
+		const size_t messages = std::max<size_t>(1, sample_bytes / message_size);
+		const double bytes = static_cast<double>(messages * message_size);
+
+		CoreCycleCounter& core = CoreCycleCounter::local();
+		EnergyCounter& energy = EnergyCounter::shared();
+		PerformanceMetric metrics(samples, bytes, static_cast<double>(messages));
+
+		for (size_t m = 0; m < messages / 10 + 1; m++) op(); // Warm up
+
+		for (size_t i = 0; i < samples; i++) {
+			EnergyCounter::Reading start_energy = energy.read();
+			uint64_t start_core = core.read();
+			uint64_t start_cycles = read_cycles();
+			auto start = std::chrono::steady_clock::now();
+
+			for (size_t m = 0; m < messages; m++) op();
+
+			uint64_t end_cycles = read_cycles();
+			auto end = std::chrono::steady_clock::now();
+			uint64_t core_cycles = core.read() - start_core;
+			EnergyCounter::Reading end_energy = energy.read();
+
+			std::chrono::duration<double> duration = end - start;
+			metrics.pushMetrics(duration, bytes / (1024.0 * 1024.0) / duration.count(), end_cycles - start_cycles, core_cycles);
+			metrics.pushEnergy(energy, start_energy, end_energy);
+		}
+
+		return metrics.finish();
+	}
+
+	inline PerformanceResults measure_seal_energy(ChaCha20& c, size_t message_size, size_t samples) {
+		CryptoHelper::buffer_vector<uint8_t> plaintext(message_size, 0xAA);
+		CryptoHelper::buffer_vector<uint8_t> ciphertext(message_size);
+		std::vector<uint8_t> aad(16, 0x03);
+		uint8_t tag[16];
+
+		return measure_messages(message_size, ENERGY_SAMPLE_BYTES, samples, [&] {
+			ChaCha20_Poly1305::encrypt(c, plaintext.data(), message_size, aad.data(), aad.size(), ciphertext.data(), tag);
+		});
+	}
+
+	inline void test_energy(size_t samples = ENERGY_SAMPLES) {
+		uint32_t key[8] = {
+			0xa9, 0xf1, 0xb3, 0x39,
+			0x04, 0xff, 0xa1, 0xb7
+		};
+
+		uint32_t nonce[3] = { 0xe5, 0xa3, 0x88 };
+
+		ChaCha20 test(key, nonce);
+
+		if (!EnergyCounter::shared().available()) {
+			std::cout << "RAPL energy counters unreadable (no /sys/class/powercap/intel-rapl:*, or not root): energy rows skipped" << std::endl;
+		}
+
+		const Tuning::Config saved = Tuning::current();
+		Tuning::Config scalar = saved;
+		scalar.batch_threshold = Tuning::DISABLED;
+#ifdef __AVX2__
+		Tuning::Config batched = saved;
+		batched.batch_threshold = 0;
+#endif
+
+		for (size_t size : ENERGY_MESSAGE_SIZES) {
+			std::vector<std::pair<std::string, PerformanceResults>> columns;
+
+			Tuning::apply(scalar);
+			columns.emplace_back("scalar", measure_seal_energy(test, size, samples));
+#ifdef __AVX2__
+			Tuning::apply(batched);
+			columns.emplace_back("8-block", measure_seal_energy(test, size, samples));
+#endif
+
+			PerformanceResults::print_comparison("ChaCha20-Poly1305 seal energy, " + std::to_string(size) + " B messages", columns);
+		}
+
+		Tuning::apply(saved);
+	}
+
+	// Primitive microbenchmarks
+
+	// Keeps the compiler from dropping or hoisting the measured work
+	inline void clobber_memory() {
+#if defined(_MSC_VER)
+		_ReadWriteBarrier();
+#else
+		asm volatile("" ::: "memory");
+#endif
+	}
+
+	// Makes a local buffer visible to clobber_memory(), so stores into it cannot be elided
+	inline void escape(void* ptr) {
+#if defined(_MSC_VER)
+		static void* volatile sink;
+		sink = ptr;
+#else
+		asm volatile("" : : "g"(ptr) : "memory");
+#endif
+	}
+
+	// Reach into the private kernels of ChaCha20 / Poly1305
+	struct PrimitiveAccess {
+		static void block_function(ChaCha20& c, uint8_t output[64]) { c.blockFunction(output, 64); }
+		static void mul_mod_p(const uint64_t* r, uint64_t* acc) { Poly1305::mul_mod_p(r, acc); }
+	};
+
+	static size_t constexpr PRIMITIVE_REPS = 10000;
+	static size_t constexpr PRIMITIVE_TRIALS = 15;
+
+	// Median over trials of (cycles for reps calls - cycles for an empty loop of reps) / reps
+	template <typename Op>
+	inline double measure_cycles_per_call(Op&& op, size_t reps = PRIMITIVE_REPS) {
+		std::vector<double> samples;
+		samples.reserve(PRIMITIVE_TRIALS);
+
+		for (size_t t = 0; t < PRIMITIVE_TRIALS; t++) {
+			uint64_t start = read_cycles();
+			for (size_t i = 0; i < reps; i++) {
+				clobber_memory();
+			}
+			uint64_t overhead = read_cycles() - start;
+
+			start = read_cycles();
+			for (size_t i = 0; i < reps; i++) {
+				op();
+				clobber_memory();
+			}
+			uint64_t total = read_cycles() - start;
+
+			double net = total > overhead ? static_cast<double>(total - overhead) : 0.0;
+			samples.push_back(net / static_cast<double>(reps));
+		}
+
+		std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+		return samples[samples.size() / 2];
+	}
+
+	inline void print_primitive(const char* name, double cycles, double bytes) {
+		std::cout << std::left << std::setw(38) << name << std::right << std::setw(12) << cycles << " c/call"
+			<< std::setw(12) << (bytes > 0 ? cycles / bytes : 0.0) << " c/B" << std::endl;
+	}
+
+	inline void test_primitives() {
+		uint32_t key[8] = {
+			0xa9, 0xf1, 0xb3, 0x39,
+			0x04, 0xff, 0xa1, 0xb7
+		};
+
+		uint32_t nonce[3] = { 0xe5, 0xa3, 0x88 };
+
+		ChaCha20 test(key, nonce);
+
+		alignas(64) uint8_t input[512];
+		alignas(64) uint8_t output[512];
+		alignas(64) uint8_t keystream[512];
+		alignas(64) uint32_t words_in[16] = { 0x61707865, 0x3320646e, 0x79622d32, 0x6b206574 };
+		alignas(64) uint32_t words_out[16];
+		std::memset(input, 0xAA, sizeof(input));
+		std::memset(keystream, 0x5C, sizeof(keystream));
+		escape(input);
+		escape(output);
+		escape(keystream);
+		escape(words_in);
+		escape(words_out);
+
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << "\n=======================================================" << std::endl;
+		std::cout << " Primitive microbenchmarks (TSC cycles, loop overhead removed)" << std::endl;
+		std::cout << "=======================================================" << std::endl;
+
+		std::cout << "[ CHACHA20 BLOCK ]" << std::endl;
+		print_primitive("  block_words (scalar kernel)", measure_cycles_per_call([&] { ChaCha20::block_words(words_in, words_out); words_in[12]++; }), 64);
+		print_primitive("  blockFunction", measure_cycles_per_call([&] { PrimitiveAccess::block_function(test, keystream); }), 64);
+		print_primitive("  keystream_blocks x8", measure_cycles_per_call([&] { ChaCha20::keystream_blocks(words_in, keystream, 8); words_in[12] += 8; }), 512);
+		print_primitive("  key block derivation (counter 0)", measure_cycles_per_call([&] {
+			uint8_t key_block[64] = { 0 };
+			test.set_counter(0);
+			test.process(key_block, key_block, 64);
+			std::memcpy(output, key_block, 64);
+		}), 64);
+
+		std::cout << "\n[ XOR KERNELS ]" << std::endl;
+		print_primitive("  process256_chunk", measure_cycles_per_call([&] { process256_chunk(input, output, keystream); }), 32);
+		print_primitive("  process128_chunk", measure_cycles_per_call([&] { process128_chunk(input, output, keystream); }), 16);
+		print_primitive("  process64_chunk", measure_cycles_per_call([&] { process64_chunk(input, output, keystream); }), 8);
+		print_primitive("  process32_chunk", measure_cycles_per_call([&] { process32_chunk(input, output, keystream); }), 4);
+
+		std::cout << "\n[ POLY1305 ]" << std::endl;
+		{
+			uint8_t poly_key[64];
+			std::memset(poly_key, 0x42, sizeof(poly_key));
+			Poly1305 p(poly_key);
+
+			uint64_t r[5] = { 0x1234567, 0x0abcdef, 0x2345678, 0x0bcdef0, 0x0345678 };
+			uint64_t acc[5] = { 1, 2, 3, 4, 5 };
+			uint8_t tag[16];
+			escape(r);
+			escape(acc);
+			escape(tag);
+
+			print_primitive("  update (one 16-byte block)", measure_cycles_per_call([&] { p.update(input, 16); }), 16);
+			print_primitive("  update (256 bytes)", measure_cycles_per_call([&] { p.update(input, 256); }), 256);
+			print_primitive("  mul_mod_p", measure_cycles_per_call([&] { PrimitiveAccess::mul_mod_p(r, acc); }), 16);
+			print_primitive("  final_", measure_cycles_per_call([&] { p.final_(tag); }), 16);
+			print_primitive("  setup (clamp + mlock)", measure_cycles_per_call([&] { Poly1305 q(poly_key); clobber_memory(); }, PRIMITIVE_REPS / 10), 0);
+		}
+
+		std::cout << "\n[ FIXED-FORMAT RECORDS (13 B AAD) ]" << std::endl;
+		{
+			Poly1305 p(std::nothrow);
+			uint8_t tag[16];
+			escape(tag);
+
+			print_primitive("  try_encrypt, 48 B", measure_cycles_per_call([&] {
+				ChaCha20_Poly1305::try_encrypt(test, p, input, 48, keystream, 13, output, tag);
+			}), 48);
+			print_primitive("  seal<13, 48>", measure_cycles_per_call([&] {
+				ChaCha20_Poly1305::seal<13, 48>(test, p, std::span<const uint8_t, 13>(keystream, 13), std::span<const uint8_t, 48>(input, 48),
+					std::span<uint8_t, 48>(output, 48), std::span<uint8_t, 16>(tag));
+			}), 48);
+			print_primitive("  try_encrypt, 192 B", measure_cycles_per_call([&] {
+				ChaCha20_Poly1305::try_encrypt(test, p, input, 192, keystream, 13, output, tag);
+			}), 192);
+			print_primitive("  seal<13, 192>", measure_cycles_per_call([&] {
+				ChaCha20_Poly1305::seal<13, 192>(test, p, std::span<const uint8_t, 13>(keystream, 13), std::span<const uint8_t, 192>(input, 192),
+					std::span<uint8_t, 192>(output, 192), std::span<uint8_t, 16>(tag));
+			}), 192);
+		}
+
+		std::cout << "\n[ TAIL CASCADE (process_tail, keystream ready) ]" << std::endl;
+		for (size_t remaining = 1; remaining < 64; remaining++) {
+			std::string label = "  " + std::to_string(remaining) + " B";
+			print_primitive(label.c_str(), measure_cycles_per_call([&] { process_tail(input, output, keystream, remaining); }), static_cast<double>(remaining));
+		}
+
+		std::cout << "=======================================================\n" << std::endl;
+	}
 }
\ No newline at end of file
@@ -0,0 +1,126 @@
+#pragma once
+#include <benchmarking/benchmark.hpp>
+#include <secure_channel.hpp>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <unistd.h>
+
+// SecureChannel over a Unix socketpair: bulk throughput with and without
+// write coalescing, and small-message round-trip latency.
+
+namespace Benchmarking {
+	static constexpr size_t CHANNEL_TOTAL_BYTES = 64 * 1024 * 1024;
+	static constexpr size_t CHANNEL_FLUSH_BYTES = 64 * 1024; // Batched mode: flush once this much was written
+	static constexpr size_t CHANNEL_MESSAGE_SIZES[] = { 64, 256, 1024, 16 * 1024 };
+	static constexpr size_t CHANNEL_PING_SIZE = 64;
+	static constexpr size_t CHANNEL_PING_ITERATIONS = 100000;
+
+	struct ChannelPair {
+		int fds[2] = { -1, -1 };
+
+		ChannelPair() {
+			if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+				throw std::runtime_error("socketpair failed");
+			}
+		}
+
+		~ChannelPair() {
+			close(fds[0]);
+			close(fds[1]);
+		}
+	};
+
+	static constexpr uint8_t CHANNEL_KEY_A[32] = { 0xa9, 0xf1, 0xb3, 0x39, 0x04, 0xff, 0xa1, 0xb7 };
+	static constexpr uint8_t CHANNEL_KEY_B[32] = { 0xe5, 0xa3, 0x88, 0x10, 0x42, 0x5c, 0x17, 0x6e };
+
+	// MB/s from the first write to the last byte read by the peer
+	inline double channel_throughput(size_t message_size, bool batched) {
+		ChannelPair pair;
+		std::vector<uint8_t> message(message_size, 0xAA);
+		const size_t messages = CHANNEL_TOTAL_BYTES / message_size;
+
+		auto start = std::chrono::steady_clock::now();
+
+		std::thread writer([&] {
+			SecureChannel::FramedChannel out(pair.fds[0], CHANNEL_KEY_A, CHANNEL_KEY_B);
+			size_t unflushed = 0;
+
+			for (size_t i = 0; i < messages; i++) {
+				out.write(message.data(), message_size);
+				unflushed += message_size;
+
+				if (!batched || unflushed >= CHANNEL_FLUSH_BYTES) {
+					out.flush();
+					unflushed = 0;
+				}
+			}
+
+			out.flush();
+		});
+
+		SecureChannel::FramedChannel in(pair.fds[1], CHANNEL_KEY_B, CHANNEL_KEY_A);
+		size_t received = 0;
+		while (received < messages * message_size) {
+			received += in.read_record().size();
+		}
+
+		auto end = std::chrono::steady_clock::now();
+		writer.join();
+
+		double seconds = std::chrono::duration<double>(end - start).count();
+		return static_cast<double>(received) / (1024.0 * 1024.0) / seconds;
+	}
+
+	inline void test_channel(size_t ping_iterations = CHANNEL_PING_ITERATIONS) {
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << "\n=======================================================" << std::endl;
+		std::cout << " SecureChannel throughput over a Unix socketpair (MB/s)" << std::endl;
+		std::cout << "=======================================================" << std::endl;
+		std::cout << std::left << std::setw(15) << "  Message" << std::right << std::setw(18) << "flush each" << std::setw(18) << "coalesced" << std::endl;
+
+		for (size_t size : CHANNEL_MESSAGE_SIZES) {
+			double single = channel_throughput(size, false);
+			double batched = channel_throughput(size, true);
+			std::string label = "  " + std::to_string(size) + " B";
+			std::cout << std::left << std::setw(15) << label << std::right << std::setw(18) << single << std::setw(18) << batched << std::endl;
+		}
+
+		// Round trip: write + flush, peer echoes the record back
+		ChannelPair pair;
+		std::thread echo([&] {
+			SecureChannel::FramedChannel peer(pair.fds[1], CHANNEL_KEY_B, CHANNEL_KEY_A);
+			for (;;) {
+				std::span<const uint8_t> record = peer.read_record();
+				if (record.empty()) return;
+
+				peer.write(record.data(), record.size());
+				peer.flush();
+			}
+		});
+
+		{
+			SecureChannel::FramedChannel client(pair.fds[0], CHANNEL_KEY_A, CHANNEL_KEY_B);
+			std::vector<uint8_t> ping(CHANNEL_PING_SIZE, 0x5C);
+
+			auto round_trip = [&] {
+				client.write(ping.data(), ping.size());
+				client.flush();
+
+				size_t got = 0;
+				while (got < ping.size()) got += client.read_record().size();
+			};
+
+			for (size_t i = 0; i < ping_iterations / 10; i++) round_trip();
+
+			LatencyResults results;
+			results.message_size = CHANNEL_PING_SIZE;
+			run_latency_test(ping_iterations, 0.0, results, round_trip);
+			results.print("SecureChannel round trip");
+
+			shutdown(pair.fds[0], SHUT_WR);
+		}
+
+		echo.join();
+	}
+}
+#endif
@@ -0,0 +1,208 @@
+#pragma once
+#include <benchmarking/benchmark.hpp>
+#include <array>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Side-by-side ChaCha20-Poly1305 against the system libraries the build found
+// (CMake defines CHACHA20_HAVE_OPENSSL / CHACHA20_HAVE_SODIUM and links them).
+// Every size is cross-checked byte for byte before it is timed: each library
+// must produce our ciphertext and tag, and must open ours.
+
+#if defined(CHACHA20_HAVE_OPENSSL)
+#include <openssl/evp.h>
+#endif
+
+#if defined(CHACHA20_HAVE_SODIUM)
+#include <sodium.h>
+#endif
+
+namespace Benchmarking {
+	static constexpr size_t COMPARE_SIZES[] = { 64, 256, 1024, 8 * 1024, 64 * 1024, 1024 * 1024 };
+	static constexpr size_t COMPARE_SAMPLE_BYTES = 8 * 1024 * 1024;
+	static constexpr size_t COMPARE_SAMPLES = 10;
+	static constexpr size_t COMPARE_AAD_SIZE = 16;
+
+	// One implementation under test: fixed key and nonce, message buffers per call
+	struct AeadContender {
+		std::string name;
+		std::function<void(const uint8_t* pt, size_t len, const uint8_t* aad, size_t aad_len, uint8_t* ct, uint8_t tag[16])> seal;
+		std::function<bool(const uint8_t* ct, size_t len, const uint8_t* aad, size_t aad_len, const uint8_t tag[16], uint8_t* pt)> open;
+	};
+
+#if defined(CHACHA20_HAVE_OPENSSL)
+	// One EVP context re-keyed per message, like a long-lived connection
+	class OpenSslAead {
+	public:
+		OpenSslAead(const uint8_t key[32], const uint8_t nonce[12]) : ctx(EVP_CIPHER_CTX_new()) {
+			if (!ctx || EVP_CipherInit_ex(ctx, EVP_chacha20_poly1305(), nullptr, nullptr, nullptr, 1) != 1) {
+				throw std::runtime_error("OpenSSL ChaCha20-Poly1305 unavailable");
+			}
+
+			std::memcpy(this->key, key, 32);
+			std::memcpy(this->nonce, nonce, 12);
+		}
+
+		~OpenSslAead() {
+			EVP_CIPHER_CTX_free(ctx);
+			CryptoHelper::secure_zero_memory(key, sizeof(key));
+		}
+
+		void seal(const uint8_t* pt, size_t len, const uint8_t* aad, size_t aad_len, uint8_t* ct, uint8_t tag[16]) {
+			int out_len = 0;
+			bool ok = EVP_CipherInit_ex(ctx, nullptr, nullptr, key, nonce, 1) == 1
+				&& (!aad_len || EVP_CipherUpdate(ctx, nullptr, &out_len, aad, static_cast<int>(aad_len)) == 1)
+				&& (!len || EVP_CipherUpdate(ctx, ct, &out_len, pt, static_cast<int>(len)) == 1)
+				&& EVP_CipherFinal_ex(ctx, ct + len, &out_len) == 1
+				&& EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, 16, tag) == 1;
+
+			if (!ok) throw std::runtime_error("OpenSSL seal failed");
+		}
+
+		bool open(const uint8_t* ct, size_t len, const uint8_t* aad, size_t aad_len, const uint8_t tag[16], uint8_t* pt) {
+			int out_len = 0;
+			bool ok = EVP_CipherInit_ex(ctx, nullptr, nullptr, key, nonce, 0) == 1
+				&& (!aad_len || EVP_CipherUpdate(ctx, nullptr, &out_len, aad, static_cast<int>(aad_len)) == 1)
+				&& (!len || EVP_CipherUpdate(ctx, pt, &out_len, ct, static_cast<int>(len)) == 1)
+				&& EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, 16, const_cast<uint8_t*>(tag)) == 1;
+
+			return ok && EVP_CipherFinal_ex(ctx, pt + len, &out_len) == 1;
+		}
+
+		OpenSslAead(const OpenSslAead&) = delete;
+		OpenSslAead& operator=(const OpenSslAead&) = delete;
+	private:
+		EVP_CIPHER_CTX* ctx;
+		uint8_t key[32];
+		uint8_t nonce[12];
+	};
+#endif
+
+	// this library, then whichever system libraries were linked in
+	inline std::vector<AeadContender> aead_contenders(ChaCha20& c, [[maybe_unused]] const uint8_t key[32], [[maybe_unused]] const uint8_t nonce[12]) {
+		std::vector<AeadContender> contenders;
+
+		contenders.push_back({ "this library",
+			[&c](const uint8_t* pt, size_t len, const uint8_t* aad, size_t aad_len, uint8_t* ct, uint8_t tag[16]) {
+				ChaCha20_Poly1305::encrypt(c, pt, len, aad, aad_len, ct, tag);
+			},
+			[&c](const uint8_t* ct, size_t len, const uint8_t* aad, size_t aad_len, const uint8_t tag[16], uint8_t* pt) {
+				return ChaCha20_Poly1305::decrypt(c, ct, len, aad, aad_len, tag, pt);
+			} });
+
+#if defined(CHACHA20_HAVE_OPENSSL)
+		auto openssl = std::make_shared<OpenSslAead>(key, nonce);
+		contenders.push_back({ "OpenSSL",
+			[openssl](const uint8_t* pt, size_t len, const uint8_t* aad, size_t aad_len, uint8_t* ct, uint8_t tag[16]) {
+				openssl->seal(pt, len, aad, aad_len, ct, tag);
+			},
+			[openssl](const uint8_t* ct, size_t len, const uint8_t* aad, size_t aad_len, const uint8_t tag[16], uint8_t* pt) {
+				return openssl->open(ct, len, aad, aad_len, tag, pt);
+			} });
+#endif
+
+#if defined(CHACHA20_HAVE_SODIUM)
+		if (sodium_init() < 0) {
+			throw std::runtime_error("libsodium initialization failed");
+		}
+
+		auto sodium_key = std::make_shared<std::array<uint8_t, 44>>(); // key | nonce
+		std::memcpy(sodium_key->data(), key, 32);
+		std::memcpy(sodium_key->data() + 32, nonce, 12);
+
+		contenders.push_back({ "libsodium",
+			[sodium_key](const uint8_t* pt, size_t len, const uint8_t* aad, size_t aad_len, uint8_t* ct, uint8_t tag[16]) {
+				crypto_aead_chacha20poly1305_ietf_encrypt_detached(ct, tag, nullptr, pt, len, aad, aad_len, nullptr, sodium_key->data() + 32, sodium_key->data());
+			},
+			[sodium_key](const uint8_t* ct, size_t len, const uint8_t* aad, size_t aad_len, const uint8_t tag[16], uint8_t* pt) {
+				return crypto_aead_chacha20poly1305_ietf_decrypt_detached(pt, nullptr, ct, len, tag, aad, aad_len, sodium_key->data() + 32, sodium_key->data()) == 0;
+			} });
+#endif
+
+		return contenders;
+	}
+
+	// Throws if any contender disagrees with the first one on ciphertext or tag, or cannot open its output
+	inline void cross_check(std::vector<AeadContender>& contenders, size_t size) {
+		std::vector<uint8_t> plaintext(size), aad(COMPARE_AAD_SIZE);
+		for (size_t i = 0; i < size; i++) plaintext[i] = static_cast<uint8_t>(i * 131 + 7);
+		for (size_t i = 0; i < aad.size(); i++) aad[i] = static_cast<uint8_t>(i ^ 0x5A);
+
+		std::vector<uint8_t> reference(size), ciphertext(size), opened(size);
+		uint8_t reference_tag[16], tag[16];
+		contenders[0].seal(plaintext.data(), size, aad.data(), aad.size(), reference.data(), reference_tag);
+
+		for (size_t k = 1; k < contenders.size(); k++) {
+			AeadContender& other = contenders[k];
+			other.seal(plaintext.data(), size, aad.data(), aad.size(), ciphertext.data(), tag);
+
+			if (ciphertext != reference || std::memcmp(tag, reference_tag, 16) != 0) {
+				throw std::runtime_error(other.name + " output differs at " + std::to_string(size) + " B");
+			}
+
+			if (!other.open(reference.data(), size, aad.data(), aad.size(), reference_tag, opened.data()) || opened != plaintext) {
+				throw std::runtime_error(other.name + " cannot open our output at " + std::to_string(size) + " B");
+			}
+
+			if (!contenders[0].open(ciphertext.data(), size, aad.data(), aad.size(), tag, opened.data()) || opened != plaintext) {
+				throw std::runtime_error("Cannot open " + other.name + " output at " + std::to_string(size) + " B");
+			}
+		}
+	}
+
+	inline void print_relative(const std::vector<std::pair<std::string, PerformanceResults>>& columns) {
+		std::cout << std::left << std::setw(22) << "  Relative MB/s";
+		for (const auto& [name, r] : columns) {
+			std::cout << std::right << std::setw(13) << r.average_throughput / columns.front().second.average_throughput << "x";
+		}
+		std::cout << "\n" << std::endl;
+	}
+
+	inline void test_comparison(size_t samples = COMPARE_SAMPLES) {
+		uint8_t key[32], nonce[12] = { 0, 0, 0, 0, 0x4a };
+		for (size_t i = 0; i < 32; i++) key[i] = static_cast<uint8_t>(0x80 + i);
+
+		uint32_t key_words[8], nonce_words[3];
+		CryptoHelper::_8bitarray_to32bitarray(key, key_words, 32);
+		CryptoHelper::_8bitarray_to32bitarray(nonce, nonce_words, 12);
+		ChaCha20 test(key_words, nonce_words);
+
+		std::vector<AeadContender> contenders = aead_contenders(test, key, nonce);
+		if (contenders.size() == 1) {
+			std::cout << "No reference library linked (configure with OpenSSL or libsodium development files installed)" << std::endl;
+			return;
+		}
+
+		for (size_t size : COMPARE_SIZES) {
+			cross_check(contenders, size);
+
+			CryptoHelper::buffer_vector<uint8_t> plaintext(size, 0xAA);
+			CryptoHelper::buffer_vector<uint8_t> ciphertext(size);
+			CryptoHelper::buffer_vector<uint8_t> opened(size);
+			std::vector<uint8_t> aad(COMPARE_AAD_SIZE, 0x03);
+			uint8_t tag[16];
+
+			std::vector<std::pair<std::string, PerformanceResults>> seal_columns, open_columns;
+			for (AeadContender& contender : contenders) {
+				seal_columns.emplace_back(contender.name, measure_messages(size, COMPARE_SAMPLE_BYTES, samples, [&] {
+					contender.seal(plaintext.data(), size, aad.data(), aad.size(), ciphertext.data(), tag);
+				}));
+
+				// Every contender sealed the same bytes, so the last tag opens for all of them
+				open_columns.emplace_back(contender.name, measure_messages(size, COMPARE_SAMPLE_BYTES, samples, [&] {
+					if (!contender.open(ciphertext.data(), size, aad.data(), aad.size(), tag, opened.data())) {
+						throw std::runtime_error(contender.name + " failed to open during timing");
+					}
+				}));
+			}
+
+			const std::string label = std::to_string(size) + " B messages (outputs match)";
+			PerformanceResults::print_comparison("Seal, " + label, seal_columns);
+			print_relative(seal_columns);
+			PerformanceResults::print_comparison("Open, " + label, open_columns);
+			print_relative(open_columns);
+		}
+	}
+}
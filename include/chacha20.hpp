@@ -3,18 +3,55 @@
 #include <cstdint>
 #include <vector>
 #include <bit>
+#include <atomic>
+#include <mutex>
+#include <immintrin.h>
 #include "helper.hpp"
+#include "instrumentation.hpp"
+#include "tuning.hpp"
 #include <assert.h>
 
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <pthread.h> // For pthread_atfork()
+#endif
+
+namespace Benchmarking { struct PrimitiveAccess; }
+
 struct ChaCha20 {
 public:
     ChaCha20(const uint32_t key[8], const uint32_t nonce[3]);
 
+    // Exception-free construction: all-zero key and nonce until reset() succeeds
+    explicit ChaCha20(std::nothrow_t) noexcept;
+
     void set_counter(uint32_t counter);
+    void set_nonce(const uint32_t nonce[3]);
     void process(const uint8_t* input, uint8_t* output, size_t length);
 
+    // noexcept API: errors come back as a Status, zero length is a no-op
+    CryptoHelper::Status reset(const uint32_t key[8], const uint32_t nonce[3]) noexcept;
+    CryptoHelper::Status try_process(const uint8_t* input, uint8_t* output, size_t length) noexcept;
+
+    // Always regular stores, whatever the non-temporal threshold, for output that is read back right away
+    CryptoHelper::Status try_process_cached(const uint8_t* input, uint8_t* output, size_t length) noexcept;
+
+    // Messages of at least `bytes` are written with non-temporal stores (Tuning default, normally disabled)
+    static constexpr size_t NON_TEMPORAL_DISABLED = SIZE_MAX;
+    static constexpr size_t NON_TEMPORAL_SUGGESTED_THRESHOLD = 4 * 1024 * 1024;
+    void set_non_temporal_threshold(size_t bytes) { non_temporal_threshold = bytes; }
+    size_t get_non_temporal_threshold() const { return non_temporal_threshold; }
+
     static ChaCha20 genRandomParams();
 
+    // Scalar 20-round block function over a raw state, usable in constant expressions
+    static constexpr void block_words(const uint32_t input[16], uint32_t output[16]);
+
+    // Raw keystream for `blocks` consecutive counters starting at state[12] (8 blocks per AVX2 pass)
+    static void keystream_blocks(const uint32_t state[16], uint8_t* output, size_t blocks);
+
+    // Same from this key and nonce as 16 words per block, starting at first_counter; the object's own counter is left alone
+    void keystream_at(uint32_t first_counter, uint32_t* output, size_t blocks) const noexcept;
+
     ~ChaCha20() {
         CryptoHelper::secure_zero_memory(state, sizeof(state));
         CryptoHelper::unlock_memory(this, sizeof(ChaCha20));
@@ -26,17 +63,18 @@ public:
     ChaCha20(ChaCha20&&) noexcept = default;
     ChaCha20& operator=(ChaCha20&&) = delete;
 private:
+    friend struct Benchmarking::PrimitiveAccess;
+
     alignas(64) uint32_t state[16];
+    size_t non_temporal_threshold = Tuning::active().non_temporal_threshold.load(std::memory_order_relaxed);
 
-    void quarter_round(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d);
+    static constexpr void quarter_round(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d);
     void blockFunction(uint8_t output[64], size_t to_copy);
+    void process_non_temporal(const uint8_t* input, uint8_t* output, size_t length);
+    void process_batched(const uint8_t* input, uint8_t* output, size_t length);
 };
 
-inline ChaCha20::ChaCha20(const uint32_t key[8], const uint32_t nonce[3]) {
-    if(!key || !nonce) {
-        throw std::invalid_argument("Key and Nonce must not be null");
-	}
-
+inline ChaCha20::ChaCha20(std::nothrow_t) noexcept {
     CryptoHelper::lock_memory(this, sizeof(ChaCha20));
 
     this->state[0] = 0x61707865; // "expa"
@@ -44,6 +82,22 @@ inline ChaCha20::ChaCha20(const uint32_t key[8], const uint32_t nonce[3]) {
     this->state[2] = 0x79622d32; // "2-by"
     this->state[3] = 0x6b206574; // "te k"
 
+    for (size_t i = 4; i < 16; ++i) {
+        this->state[i] = 0;
+    }
+}
+
+inline ChaCha20::ChaCha20(const uint32_t key[8], const uint32_t nonce[3]) : ChaCha20(std::nothrow) {
+    if (reset(key, nonce) != CryptoHelper::Status::Ok) {
+        CRYPTO_THROW(std::invalid_argument("Key and Nonce must not be null"));
+    }
+}
+
+inline CryptoHelper::Status ChaCha20::reset(const uint32_t key[8], const uint32_t nonce[3]) noexcept {
+    if (!key || !nonce) {
+        return CryptoHelper::Status::NullPointer;
+    }
+
     for (size_t i = 0; i < 8; ++i) {
         this->state[4 + i] = key[i];
     }
@@ -54,9 +108,11 @@ inline ChaCha20::ChaCha20(const uint32_t key[8], const uint32_t nonce[3]) {
     for (size_t i = 0; i < 3; ++i) {
         this->state[13 + i] = nonce[i];
     }
+
+    return CryptoHelper::Status::Ok;
 }
 
-inline void ChaCha20::quarter_round(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) {
+constexpr void ChaCha20::quarter_round(uint32_t& a, uint32_t& b, uint32_t& c, uint32_t& d) {
     a += b; d ^= a; d = std::rotl(d, 16);
     c += d; b ^= c; b = std::rotl(b, 12);
     a += b; d ^= a; d = std::rotl(d, 8);
@@ -67,33 +123,217 @@ inline void ChaCha20::set_counter(uint32_t counter) {
     state[12] = counter;
 }
 
-inline void ChaCha20::blockFunction(uint8_t output[64], size_t to_copy = 64) {
-    assert(to_copy <= 64 && "Cannot copy more than 64 bytes");
+inline void ChaCha20::set_nonce(const uint32_t nonce[3]) {
+    for (size_t i = 0; i < 3; ++i) {
+        this->state[13 + i] = nonce[i];
+    }
+}
 
-    alignas(64) uint32_t working_state[16];
-    std::memcpy(working_state, state, 16 * sizeof(uint32_t));
+constexpr void ChaCha20::block_words(const uint32_t input[16], uint32_t output[16]) {
+    for (int i = 0; i < 16; ++i) {
+        output[i] = input[i];
+    }
 
 #pragma loop(ivdep)
     for (int i = 0; i < 10; ++i) {
         // Column rounds
-        quarter_round(working_state[0], working_state[4], working_state[8], working_state[12]);
-        quarter_round(working_state[1], working_state[5], working_state[9], working_state[13]);
-        quarter_round(working_state[2], working_state[6], working_state[10], working_state[14]);
-        quarter_round(working_state[3], working_state[7], working_state[11], working_state[15]);
+        quarter_round(output[0], output[4], output[8], output[12]);
+        quarter_round(output[1], output[5], output[9], output[13]);
+        quarter_round(output[2], output[6], output[10], output[14]);
+        quarter_round(output[3], output[7], output[11], output[15]);
         // Diagonal rounds
-        quarter_round(working_state[0], working_state[5], working_state[10], working_state[15]);
-        quarter_round(working_state[1], working_state[6], working_state[11], working_state[12]);
-        quarter_round(working_state[2], working_state[7], working_state[8], working_state[13]);
-        quarter_round(working_state[3], working_state[4], working_state[9], working_state[14]);
+        quarter_round(output[0], output[5], output[10], output[15]);
+        quarter_round(output[1], output[6], output[11], output[12]);
+        quarter_round(output[2], output[7], output[8], output[13]);
+        quarter_round(output[3], output[4], output[9], output[14]);
     }
 
 #pragma loop(ivdep)
     for (int i = 0; i < 16; ++i) {
-        working_state[i] += state[i];
+        output[i] += input[i];
     }
+}
+
+inline void ChaCha20::blockFunction(uint8_t output[64], size_t to_copy = 64) {
+    assert(to_copy <= 64 && "Cannot copy more than 64 bytes");
+
+    alignas(64) uint32_t working_state[16];
+    block_words(state, working_state);
 
     std::memcpy(output, working_state, to_copy);
     state[12]++;
+
+    Instrumentation::add(Instrumentation::KEYSTREAM_BLOCKS);
+}
+
+#ifdef __AVX2__
+inline __m256i rotl_epi32(__m256i v, int bits) {
+    return _mm256_or_si256(_mm256_slli_epi32(v, bits), _mm256_srli_epi32(v, 32 - bits));
+}
+
+inline void quarter_round_x8(__m256i& a, __m256i& b, __m256i& c, __m256i& d) {
+    const __m256i rot16 = _mm256_setr_epi8(
+        2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13,
+        2, 3, 0, 1, 6, 7, 4, 5, 10, 11, 8, 9, 14, 15, 12, 13);
+    const __m256i rot8 = _mm256_setr_epi8(
+        3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14,
+        3, 0, 1, 2, 7, 4, 5, 6, 11, 8, 9, 10, 15, 12, 13, 14);
+
+    a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot16);
+    c = _mm256_add_epi32(c, d); b = rotl_epi32(_mm256_xor_si256(b, c), 12);
+    a = _mm256_add_epi32(a, b); d = _mm256_shuffle_epi8(_mm256_xor_si256(d, a), rot8);
+    c = _mm256_add_epi32(c, d); b = rotl_epi32(_mm256_xor_si256(b, c), 7);
+}
+
+// 20 rounds over eight states at once, x[i] holds word i of every lane
+inline void chacha20_rounds_x8(__m256i x[16]) {
+    for (int i = 0; i < 10; ++i) {
+        // Column rounds
+        quarter_round_x8(x[0], x[4], x[8], x[12]);
+        quarter_round_x8(x[1], x[5], x[9], x[13]);
+        quarter_round_x8(x[2], x[6], x[10], x[14]);
+        quarter_round_x8(x[3], x[7], x[11], x[15]);
+        // Diagonal rounds
+        quarter_round_x8(x[0], x[5], x[10], x[15]);
+        quarter_round_x8(x[1], x[6], x[11], x[12]);
+        quarter_round_x8(x[2], x[7], x[8], x[13]);
+        quarter_round_x8(x[3], x[4], x[9], x[14]);
+    }
+}
+#endif
+
+// Four-lane SSE2 variant for short runs (3-7 blocks), where an 8-lane pass would waste lanes
+inline __m128i rotl_epi32_x4(__m128i v, int bits) {
+    return _mm_or_si128(_mm_slli_epi32(v, bits), _mm_srli_epi32(v, 32 - bits));
+}
+
+inline void quarter_round_x4(__m128i& a, __m128i& b, __m128i& c, __m128i& d) {
+    a = _mm_add_epi32(a, b); d = rotl_epi32_x4(_mm_xor_si128(d, a), 16);
+    c = _mm_add_epi32(c, d); b = rotl_epi32_x4(_mm_xor_si128(b, c), 12);
+    a = _mm_add_epi32(a, b); d = rotl_epi32_x4(_mm_xor_si128(d, a), 8);
+    c = _mm_add_epi32(c, d); b = rotl_epi32_x4(_mm_xor_si128(b, c), 7);
+}
+
+inline void chacha20_rounds_x4(__m128i x[16]) {
+    for (int i = 0; i < 10; ++i) {
+        quarter_round_x4(x[0], x[4], x[8], x[12]);
+        quarter_round_x4(x[1], x[5], x[9], x[13]);
+        quarter_round_x4(x[2], x[6], x[10], x[14]);
+        quarter_round_x4(x[3], x[7], x[11], x[15]);
+        quarter_round_x4(x[0], x[5], x[10], x[15]);
+        quarter_round_x4(x[1], x[6], x[11], x[12]);
+        quarter_round_x4(x[2], x[7], x[8], x[13]);
+        quarter_round_x4(x[3], x[4], x[9], x[14]);
+    }
+}
+
+inline void ChaCha20::keystream_blocks(const uint32_t state[16], uint8_t* output, size_t blocks) {
+    Instrumentation::add(Instrumentation::KEYSTREAM_BLOCKS, blocks);
+
+    size_t i = 0;
+
+#ifdef __AVX2__
+    alignas(32) uint32_t words[16][8];
+
+    for (; i + 8 <= blocks; i += 8) {
+        __m256i in[16], x[16];
+        for (size_t w = 0; w < 16; ++w) {
+            in[w] = _mm256_set1_epi32(static_cast<int>(state[w]));
+        }
+        in[12] = _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(state[12] + i)), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+
+        for (size_t w = 0; w < 16; ++w) x[w] = in[w];
+        chacha20_rounds_x8(x);
+
+        for (size_t w = 0; w < 16; ++w) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(words[w]), _mm256_add_epi32(x[w], in[w]));
+        }
+
+        // Transpose lanes back into consecutive 64-byte blocks
+        for (size_t lane = 0; lane < 8; ++lane) {
+            for (size_t w = 0; w < 16; ++w) {
+                std::memcpy(output + (i + lane) * 64 + w * 4, &words[w][lane], 4);
+            }
+        }
+    }
+
+    if (i) CryptoHelper::secure_zero_memory(words, sizeof(words)); // Untouched below 8 blocks
+#endif
+
+    alignas(64) uint32_t input[16];
+    alignas(64) uint32_t block[16];
+    std::memcpy(input, state, sizeof(input));
+
+    for (; i < blocks; ++i) {
+        input[12] = state[12] + static_cast<uint32_t>(i);
+        block_words(input, block);
+        std::memcpy(output + i * 64, block, 64);
+    }
+
+    CryptoHelper::secure_zero_memory(input, sizeof(input));
+    CryptoHelper::secure_zero_memory(block, sizeof(block));
+}
+
+inline void ChaCha20::keystream_at(uint32_t first_counter, uint32_t* output, size_t blocks) const noexcept {
+    alignas(64) uint32_t input[16];
+    std::memcpy(input, state, sizeof(input));
+    input[12] = first_counter;
+
+    if (blocks >= 8) {
+        keystream_blocks(input, reinterpret_cast<uint8_t*>(output), blocks);
+    }
+    else {
+        // Short runs (fixed-length records): four counters per SSE2 pass while at least three
+        // blocks remain (below that scalar blocks are cheaper), the rest scalar
+        size_t i = 0;
+
+        for (; i + 3 <= blocks; i += 4) {
+            const __m128i counters = _mm_add_epi32(_mm_set1_epi32(static_cast<int>(input[12])), _mm_setr_epi32(0, 1, 2, 3));
+
+            __m128i x[16];
+            for (size_t w = 0; w < 16; ++w) {
+                x[w] = _mm_set1_epi32(static_cast<int>(input[w]));
+            }
+            x[12] = counters;
+
+            chacha20_rounds_x4(x);
+
+            // Re-broadcast instead of keeping a second set of 16 registers live
+            for (size_t w = 0; w < 16; ++w) {
+                x[w] = _mm_add_epi32(x[w], w == 12 ? counters : _mm_set1_epi32(static_cast<int>(input[w])));
+            }
+
+            // 4x4 transposes: lane k's words w..w+3 land in output block i + k
+            size_t lanes = blocks - i < 4 ? blocks - i : 4;
+            for (size_t w = 0; w < 16; w += 4) {
+                __m128i t0 = _mm_unpacklo_epi32(x[w], x[w + 1]);
+                __m128i t1 = _mm_unpacklo_epi32(x[w + 2], x[w + 3]);
+                __m128i t2 = _mm_unpackhi_epi32(x[w], x[w + 1]);
+                __m128i t3 = _mm_unpackhi_epi32(x[w + 2], x[w + 3]);
+                __m128i rows[4] = { _mm_unpacklo_epi64(t0, t1), _mm_unpackhi_epi64(t0, t1), _mm_unpacklo_epi64(t2, t3), _mm_unpackhi_epi64(t2, t3) };
+
+                for (size_t lane = 0; lane < lanes; ++lane) {
+                    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + (i + lane) * 16 + w), rows[lane]);
+                }
+            }
+
+            input[12] += 4;
+        }
+
+        if (i < blocks) {
+            alignas(64) uint32_t block[16]; // Local, so the rounds stay in registers
+            for (; i < blocks; ++i) {
+                block_words(input, block);
+                std::memcpy(output + i * 16, block, sizeof(block));
+                input[12]++;
+            }
+            CryptoHelper::secure_zero_memory(block, sizeof(block));
+        }
+
+        Instrumentation::add(Instrumentation::KEYSTREAM_BLOCKS, blocks);
+    }
+
+    CryptoHelper::secure_zero_memory(input, sizeof(input));
 }
 
 inline void process256_chunk(const uint8_t* input, uint8_t* output, const uint8_t* keyStream) {
@@ -146,10 +386,173 @@ inline void process_manually(const uint8_t* input, uint8_t* output, const uint8_
     }
 }
 
+// Cascade for the final partial block (1-63 bytes)
+inline void process_tail(const uint8_t* input, uint8_t* output, const uint8_t* keyStream, size_t remaining) {
+    size_t local_off = 0;
+
+    if (remaining - local_off >= 32) {
+        process256_chunk(input + local_off, output + local_off, keyStream + local_off);
+        local_off += 32;
+    }
+    if (remaining - local_off >= 16) {
+        process128_chunk(input + local_off, output + local_off, keyStream + local_off);
+        local_off += 16;
+    }
+    if (remaining - local_off >= 8) {
+        process64_chunk(input + local_off, output + local_off, keyStream + local_off);
+        local_off += 8;
+    }
+
+    if (remaining - local_off > 0) {
+        process_manually(input + local_off, output + local_off, keyStream + local_off, remaining - local_off);
+    }
+}
+
+// Non-temporal variants: output must be 32-byte aligned, callers issue _mm_sfence() once done
+
+inline void stream256_chunk(const uint8_t* input, uint8_t* output, const uint8_t* keyStream) {
+    #ifdef __AVX2__
+        __m256i in = _mm256_loadu_si256((const __m256i*)input);
+        __m256i key = _mm256_loadu_si256((const __m256i*)keyStream);
+        _mm256_stream_si256((__m256i*)output, _mm256_xor_si256(in, key));
+    #else
+        __m128i in_lo = _mm_loadu_si128((const __m128i*)input);
+        __m128i in_hi = _mm_loadu_si128((const __m128i*)(input + 16));
+        __m128i key_lo = _mm_loadu_si128((const __m128i*)keyStream);
+        __m128i key_hi = _mm_loadu_si128((const __m128i*)(keyStream + 16));
+
+        _mm_stream_si128((__m128i*)output, _mm_xor_si128(in_lo, key_lo));
+        _mm_stream_si128((__m128i*)(output + 16), _mm_xor_si128(in_hi, key_hi));
+    #endif
+}
+
+// memcpy that bypasses the cache for everything past the aligned head
+inline void stream_copy(uint8_t* dst, const uint8_t* src, size_t length) {
+    size_t head = (32 - reinterpret_cast<uintptr_t>(dst) % 32) % 32;
+    if (head > length) head = length;
+
+    std::memcpy(dst, src, head);
+
+    size_t offset = head;
+    for (; offset + 32 <= length; offset += 32) {
+    #ifdef __AVX2__
+        _mm256_stream_si256((__m256i*)(dst + offset), _mm256_loadu_si256((const __m256i*)(src + offset)));
+    #else
+        _mm_stream_si128((__m128i*)(dst + offset), _mm_loadu_si128((const __m128i*)(src + offset)));
+        _mm_stream_si128((__m128i*)(dst + offset + 16), _mm_loadu_si128((const __m128i*)(src + offset + 16)));
+    #endif
+    }
+
+    std::memcpy(dst + offset, src + offset, length - offset);
+}
+
+inline void ChaCha20::process_non_temporal(const uint8_t* input, uint8_t* output, size_t length) {
+    const uint32_t first_counter = state[12];
+    alignas(64) uint8_t keystream[8 * 64];
+    size_t ks_begin = 0, ks_end = 0; // Message offsets currently covered by keystream
+
+    // Output alignment does not follow block boundaries, so keep a window of 8 blocks around pos
+    auto keystream_at = [&](size_t pos, size_t n) -> const uint8_t* {
+        if (pos < ks_begin || pos + n > ks_end) {
+            size_t block = pos / 64;
+            state[12] = first_counter + static_cast<uint32_t>(block);
+            keystream_blocks(state, keystream, 8);
+            ks_begin = block * 64;
+            ks_end = ks_begin + sizeof(keystream);
+        }
+        return keystream + (pos - ks_begin);
+    };
+
+    // 1. Regular stores until the output is 32-byte aligned
+    size_t offset = (32 - reinterpret_cast<uintptr_t>(output) % 32) % 32;
+    if (offset > length) offset = length;
+
+    if (offset) {
+        process_manually(input, output, keystream_at(0, offset), offset);
+    }
+
+    // 2. Aligned streaming stores, no read-for-ownership of the output lines
+    for (; offset + 32 <= length; offset += 32) {
+        stream256_chunk(input + offset, output + offset, keystream_at(offset, 32));
+    }
+
+    _mm_sfence();
+
+    // 3. Tail
+    if (offset < length) {
+        process_manually(input + offset, output + offset, keystream_at(offset, length - offset), length - offset);
+    }
+
+    state[12] = first_counter + static_cast<uint32_t>((length + 63) / 64);
+    CryptoHelper::secure_zero_memory(keystream, sizeof(keystream));
+}
+
+// Eight keystream blocks per pass instead of one blockFunction call per 64 bytes
+inline void ChaCha20::process_batched(const uint8_t* input, uint8_t* output, size_t length) {
+    alignas(64) uint8_t keystream[8 * 64];
+    size_t offset = 0;
+
+    while (offset < length) {
+        size_t n = length - offset < sizeof(keystream) ? length - offset : sizeof(keystream);
+        size_t blocks = (n + 63) / 64;
+
+        keystream_blocks(state, keystream, blocks);
+        state[12] += static_cast<uint32_t>(blocks);
+
+        size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            process256_chunk(input + offset + i, output + offset + i, keystream + i);
+        }
+        if (i < n) {
+            process_tail(input + offset + i, output + offset + i, keystream + i, n - i);
+        }
+
+        offset += n;
+    }
+
+    CryptoHelper::secure_zero_memory(keystream, sizeof(keystream));
+}
+
 inline void ChaCha20::process(const uint8_t* input, uint8_t* output, size_t length) {
-    if(!input || !output || length == 0) {
-		throw::std::invalid_argument("Input and Output buffers must not be null, and length must be greater than zero");
-	}
+    if (try_process(input, output, length) != CryptoHelper::Status::Ok) {
+        CRYPTO_THROW(std::invalid_argument("Input and Output buffers must not be null"));
+    }
+}
+
+inline CryptoHelper::Status ChaCha20::try_process_cached(const uint8_t* input, uint8_t* output, size_t length) noexcept {
+    if (length == 0) {
+        return CryptoHelper::Status::Ok;
+    }
+
+    if (!input || !output) {
+        return CryptoHelper::Status::NullPointer;
+    }
+
+    Instrumentation::add(Instrumentation::CIPHER_BYTES, length);
+    process_batched(input, output, length);
+    return CryptoHelper::Status::Ok;
+}
+
+inline CryptoHelper::Status ChaCha20::try_process(const uint8_t* input, uint8_t* output, size_t length) noexcept {
+    if (length == 0) {
+        return CryptoHelper::Status::Ok;
+    }
+
+    if (!input || !output) {
+        return CryptoHelper::Status::NullPointer;
+    }
+
+    Instrumentation::add(Instrumentation::CIPHER_BYTES, length);
+
+    if (length >= non_temporal_threshold) {
+        process_non_temporal(input, output, length);
+        return CryptoHelper::Status::Ok;
+    }
+
+    if (length >= Tuning::active().batch_threshold.load(std::memory_order_relaxed)) {
+        process_batched(input, output, length);
+        return CryptoHelper::Status::Ok;
+    }
 
     size_t offset = 0;
     alignas(64) uint8_t keystream[256];
@@ -169,25 +572,113 @@ inline void ChaCha20::process(const uint8_t* input, uint8_t* output, size_t leng
     // 2. Handle the final partial block (0-63 bytes left)
     if (offset < length) {
         blockFunction(keystream); // Generate one last keystream block
-        size_t remaining = length - offset;
+        process_tail(input + offset, output + offset, keystream, length - offset);
+    }
+
+    return CryptoHelper::Status::Ok;
+}
 
-        size_t local_off = 0;
+// Per-thread buffered ChaCha20 DRBG
 
-        if (remaining - local_off >= 32) {
-            process256_chunk(input + offset + local_off, output + offset + local_off, keystream + local_off);
-            local_off += 32;
+namespace CryptoHelper {
+    static constexpr size_t FAST_RANDOM_BLOCKS = 16;
+    static constexpr size_t FAST_RANDOM_BUFFER = FAST_RANDOM_BLOCKS * 64;
+    static constexpr uint64_t FAST_RANDOM_RESEED_INTERVAL = 1024 * 1024; // Bytes served between getrandom reseeds
+
+    // Bumped in the child after fork() so every thread state reseeds instead of replaying the parent's stream
+    inline std::atomic<uint64_t> fast_random_fork_generation{ 1 };
+
+    inline void register_fast_random_fork_handler() {
+#if !defined(_WIN32) && !defined(_WIN64)
+        static std::once_flag registered;
+        std::call_once(registered, [] {
+            pthread_atfork(nullptr, nullptr, [] { fast_random_fork_generation.fetch_add(1, std::memory_order_relaxed); });
+        });
+#endif
+    }
+
+    struct FastRandomState {
+        alignas(64) uint32_t state[16];
+        alignas(64) uint8_t buffer[FAST_RANDOM_BUFFER];
+        size_t available = 0;
+        uint64_t served_since_reseed = 0;
+        uint64_t fork_generation = 0; // 0 = never seeded
+
+        FastRandomState() {
+            lock_memory(this, sizeof(FastRandomState));
+            register_fast_random_fork_handler();
         }
-        if (remaining - local_off >= 16) {
-            process128_chunk(input + offset + local_off, output + offset + local_off, keystream + local_off);
-            local_off += 16;
+
+        ~FastRandomState() {
+            secure_zero_memory(state, sizeof(state));
+            secure_zero_memory(buffer, sizeof(buffer));
+            unlock_memory(this, sizeof(FastRandomState));
         }
-        if (remaining - local_off >= 8) {
-            process64_chunk(input + offset + local_off, output + offset + local_off, keystream + local_off);
-            local_off += 8;
+
+        void reseed() {
+            uint8_t seed[44];
+            gen_secure_random_bytes(seed, sizeof(seed));
+
+            state[0] = 0x61707865; // "expa"
+            state[1] = 0x3320646e; // "nd 3"
+            state[2] = 0x79622d32; // "2-by"
+            state[3] = 0x6b206574; // "te k"
+            _8bitarray_to32bitarray(seed, state + 4, 32);
+            state[12] = 0;
+            _8bitarray_to32bitarray(seed + 32, state + 13, 12);
+
+            secure_zero_memory(seed, sizeof(seed));
+            secure_zero_memory(buffer, sizeof(buffer));
+            available = 0;
+            served_since_reseed = 0;
+            fork_generation = fast_random_fork_generation.load(std::memory_order_relaxed);
+        }
+
+        // Fast key erasure: the first 32 bytes of every refill become the next key
+        void refill() {
+            ChaCha20::keystream_blocks(state, buffer, FAST_RANDOM_BLOCKS);
+            _8bitarray_to32bitarray(buffer, state + 4, 32);
+            secure_zero_memory(buffer, 32);
+            available = FAST_RANDOM_BUFFER - 32;
+        }
+    };
+
+    inline void fast_random_bytes(uint8_t* buffer, size_t length) {
+        thread_local FastRandomState rng;
+
+        if (rng.fork_generation != fast_random_fork_generation.load(std::memory_order_relaxed) ||
+            rng.served_since_reseed >= FAST_RANDOM_RESEED_INTERVAL) {
+            rng.reseed();
         }
 
-        if (remaining - local_off > 0) {
-            process_manually(input + offset + local_off, output + offset + local_off, keystream + local_off, remaining - local_off);
+        while (length > 0) {
+            if (rng.available == 0) rng.refill();
+
+            size_t take = length < rng.available ? length : rng.available;
+            uint8_t* src = rng.buffer + (FAST_RANDOM_BUFFER - rng.available);
+
+            std::memcpy(buffer, src, take);
+            secure_zero_memory(src, take);
+
+            rng.available -= take;
+            rng.served_since_reseed += take;
+            buffer += take;
+            length -= take;
         }
     }
-}
\ No newline at end of file
+}
+
+inline ChaCha20 ChaCha20::genRandomParams() {
+    uint32_t key[8];
+    uint32_t nonce[3];
+
+    CryptoHelper::fast_random_bytes(reinterpret_cast<uint8_t*>(key), sizeof(key));
+    CryptoHelper::fast_random_bytes(reinterpret_cast<uint8_t*>(nonce), sizeof(nonce));
+
+    ChaCha20 c(key, nonce);
+
+    CryptoHelper::secure_zero_memory(key, sizeof(key));
+    CryptoHelper::secure_zero_memory(nonce, sizeof(nonce));
+
+    return c;
+}
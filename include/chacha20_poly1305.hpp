@@ -1,7 +1,9 @@
 #pragma once
 #include <poly1305.hpp>
 #include <chacha20.hpp>
+#include <rfc8439_kat.hpp>
 #include <cstdint>
+#include <span>
 
 namespace ChaCha20_Poly1305 {
     // Poly Helper Function
@@ -14,19 +16,52 @@ namespace ChaCha20_Poly1305 {
         }
     }
 
-    inline void encrypt(
-        ChaCha20& c,
+    // RFC 8439 section 2.8: at most 2^32 - 1 keystream blocks after the Poly1305 key block
+    static constexpr uint64_t MAX_MESSAGE_SIZE = (uint64_t(1) << 38) - 64;
+
+    inline bool constant_time_compare(const uint8_t* a, const uint8_t* b, size_t len) {
+        uint8_t diff = 0;
+        for (size_t i = 0; i < len; i++) {
+            diff |= a[i] ^ b[i];
+        }
+
+        return diff == 0;
+    }
+
+    inline CryptoHelper::Status check_arguments(const uint8_t* input, const uint8_t* output, size_t length, const uint8_t* aad, size_t aad_len, const void* tag) noexcept {
+        if ((length && (!input || !output)) || (aad_len && !aad) || !tag) {
+            return CryptoHelper::Status::NullPointer;
+        }
+
+        if (static_cast<uint64_t>(length) > MAX_MESSAGE_SIZE) {
+            return CryptoHelper::Status::MessageTooLong;
+        }
+
+        return CryptoHelper::Status::Ok;
+    }
+
+    // Poly1305 one-time key (counter = 0) into a reusable MAC
+    inline void derive_mac_key(ChaCha20& c, Poly1305& p) noexcept {
+        uint8_t key_block[64] = { 0 };
+        c.set_counter(0);
+        c.try_process_cached(key_block, key_block, 64);
+
+        p.reset(key_block);
+        CryptoHelper::secure_zero_memory(key_block, sizeof(key_block));
+    }
+
+    // Keyed steps: arguments already checked and p already holds this message's one-time key.
+    // Lets batch callers derive the one-time keys of several messages in one pass.
+
+    inline CryptoHelper::Status seal_keyed(
+        ChaCha20& c, Poly1305& p,
         const uint8_t* plaintext, size_t plaintext_len,
         const uint8_t* aad, size_t aad_len,
         uint8_t* output,
-        uint8_t* tag)
+        uint8_t* tag) noexcept
     {
-        // 1. Poly1305 one-time key (counter = 0)
-        uint8_t key_block[64] = { 0 };
-        c.set_counter(0);
-        c.process(key_block, key_block, 64);
-
-        Poly1305 p(key_block);
+        Instrumentation::CallSample sample;
+        Instrumentation::record_aead(Instrumentation::AEAD_SEALS, plaintext_len);
 
         // 2. AAD
         if (aad_len) {
@@ -36,47 +71,53 @@ namespace ChaCha20_Poly1305 {
 
         // 3. Encrypt plaintext (counter = 1)
         c.set_counter(1);
-        c.process(plaintext, output, plaintext_len);
 
-        // 4. Ciphertext
-        if (plaintext_len) {
+        if (plaintext_len >= c.get_non_temporal_threshold()) {
+            // Encrypt through an L1-resident scratch so Poly1305 reads the ciphertext from cache,
+            // then stream it out without pulling the output lines in
+            alignas(64) uint8_t scratch[4096];
+
+            for (size_t offset = 0; offset < plaintext_len; offset += sizeof(scratch)) {
+                size_t n = min_(sizeof(scratch), plaintext_len - offset);
+                c.try_process_cached(plaintext + offset, scratch, n);
+                p.update(scratch, n);
+                stream_copy(output + offset, scratch, n);
+            }
+
+            _mm_sfence();
+            CryptoHelper::secure_zero_memory(scratch, sizeof(scratch));
+            poly_pad16(p, plaintext_len);
+        }
+        else if (plaintext_len) {
+            c.try_process(plaintext, output, plaintext_len);
+
+            // 4. Ciphertext
             p.update(output, plaintext_len);
             poly_pad16(p, plaintext_len);
         }
 
         // 5. Lengths (LE64)
-        uint64_t aad_len_le = aad_len;
-        uint64_t ct_len_le = plaintext_len;
-
-        p.update(reinterpret_cast<uint8_t*>(&aad_len_le), 8);
-        p.update(reinterpret_cast<uint8_t*>(&ct_len_le), 8);
+        uint8_t lengths[16];
+        CryptoHelper::store_le64(lengths, aad_len);
+        CryptoHelper::store_le64(lengths + 8, plaintext_len);
+        p.update(lengths, 16);
 
         // 6. Final tag
         p.final_(tag);
-    }
-
-    inline bool constant_time_compare(const uint8_t* a, const uint8_t* b, size_t len) {
-        uint8_t diff = 0;
-        for (size_t i = 0; i < len; i++) {
-            diff |= a[i] ^ b[i];
-        }
 
-        return diff == 0;
+        return CryptoHelper::Status::Ok;
     }
 
-    inline bool decrypt(
-        ChaCha20& c,
+    // AuthenticationFailed leaves output untouched
+    inline CryptoHelper::Status open_keyed(
+        ChaCha20& c, Poly1305& p,
         const uint8_t* ciphertext, size_t ciphertext_len,
         const uint8_t* aad, size_t aad_len,
         const uint8_t* received_tag,
-        uint8_t* output)
+        uint8_t* output) noexcept
     {
-        // 1. Poly1305 key (counter = 0)
-        uint8_t key_block[64] = { 0 };
-        c.set_counter(0);
-        c.process(key_block, key_block, 64);
-
-        Poly1305 p(key_block);
+        Instrumentation::CallSample sample;
+        Instrumentation::record_aead(Instrumentation::AEAD_OPENS, ciphertext_len);
 
         // 2. AAD
         if (aad_len) {
@@ -91,24 +132,452 @@ namespace ChaCha20_Poly1305 {
         }
 
         // 4. Lengths
-        uint64_t aad_len_le = aad_len;
-        uint64_t ct_len_le = ciphertext_len;
-
-        p.update(reinterpret_cast<uint8_t*>(&aad_len_le), 8);
-        p.update(reinterpret_cast<uint8_t*>(&ct_len_le), 8);
+        uint8_t lengths[16];
+        CryptoHelper::store_le64(lengths, aad_len);
+        CryptoHelper::store_le64(lengths + 8, ciphertext_len);
+        p.update(lengths, 16);
 
         // 5. Verify tag (constant time)
         uint8_t calc_tag[16];
         p.final_(calc_tag);
 
         if(!constant_time_compare(calc_tag, received_tag, 16)) {
-            return false; // Authentication failed
+            Instrumentation::add(Instrumentation::AUTH_FAILURES);
+            return CryptoHelper::Status::AuthenticationFailed;
 		}
 
         // 6. Decrypt only after authentication
         c.set_counter(1);
-        c.process(ciphertext, output, ciphertext_len);
+        c.try_process(ciphertext, output, ciphertext_len);
+
+        return CryptoHelper::Status::Ok;
+    }
+
+    // noexcept API. An empty plaintext and/or AAD is valid and still produces a tag.
+    // The overloads taking a Poly1305 reuse it as scratch (see Poly1305(std::nothrow)).
+
+    inline CryptoHelper::Status try_encrypt(
+        ChaCha20& c, Poly1305& p,
+        const uint8_t* plaintext, size_t plaintext_len,
+        const uint8_t* aad, size_t aad_len,
+        uint8_t* output,
+        uint8_t* tag) noexcept
+    {
+        CryptoHelper::Status status = check_arguments(plaintext, output, plaintext_len, aad, aad_len, tag);
+        if (status != CryptoHelper::Status::Ok) return status;
+
+        derive_mac_key(c, p);
+        return seal_keyed(c, p, plaintext, plaintext_len, aad, aad_len, output, tag);
+    }
+
+    inline CryptoHelper::Status try_encrypt(
+        ChaCha20& c,
+        const uint8_t* plaintext, size_t plaintext_len,
+        const uint8_t* aad, size_t aad_len,
+        uint8_t* output,
+        uint8_t* tag) noexcept
+    {
+        Poly1305 p(std::nothrow);
+        return try_encrypt(c, p, plaintext, plaintext_len, aad, aad_len, output, tag);
+    }
+
+    inline CryptoHelper::Status try_decrypt(
+        ChaCha20& c, Poly1305& p,
+        const uint8_t* ciphertext, size_t ciphertext_len,
+        const uint8_t* aad, size_t aad_len,
+        const uint8_t* received_tag,
+        uint8_t* output) noexcept
+    {
+        CryptoHelper::Status status = check_arguments(ciphertext, output, ciphertext_len, aad, aad_len, received_tag);
+        if (status != CryptoHelper::Status::Ok) return status;
+
+        derive_mac_key(c, p);
+        return open_keyed(c, p, ciphertext, ciphertext_len, aad, aad_len, received_tag, output);
+    }
+
+    inline CryptoHelper::Status try_decrypt(
+        ChaCha20& c,
+        const uint8_t* ciphertext, size_t ciphertext_len,
+        const uint8_t* aad, size_t aad_len,
+        const uint8_t* received_tag,
+        uint8_t* output) noexcept
+    {
+        Poly1305 p(std::nothrow);
+        return try_decrypt(c, p, ciphertext, ciphertext_len, aad, aad_len, received_tag, output);
+    }
+
+    // Throwing API on top of the noexcept one
+
+    inline void encrypt(
+        ChaCha20& c,
+        const uint8_t* plaintext, size_t plaintext_len,
+        const uint8_t* aad, size_t aad_len,
+        uint8_t* output,
+        uint8_t* tag)
+    {
+        CryptoHelper::Status status = try_encrypt(c, plaintext, plaintext_len, aad, aad_len, output, tag);
+        if (status != CryptoHelper::Status::Ok) {
+            CRYPTO_THROW(std::invalid_argument(CryptoHelper::status_message(status)));
+        }
+    }
+
+    // False when authentication fails
+    inline bool decrypt(
+        ChaCha20& c,
+        const uint8_t* ciphertext, size_t ciphertext_len,
+        const uint8_t* aad, size_t aad_len,
+        const uint8_t* received_tag,
+        uint8_t* output)
+    {
+        CryptoHelper::Status status = try_decrypt(c, ciphertext, ciphertext_len, aad, aad_len, received_tag, output);
+        if (status == CryptoHelper::Status::AuthenticationFailed) {
+            return false;
+        }
+
+        if (status != CryptoHelper::Status::Ok) {
+            CRYPTO_THROW(std::invalid_argument(CryptoHelper::status_message(status)));
+        }
 
         return true;
     }
-}
\ No newline at end of file
+
+    // Fixed-length records (e.g. 13-byte AAD and a 48-byte payload).
+    // Lengths are template parameters, so padding, the length block and the tail
+    // are resolved at compile time: one keystream call covers the Poly1305 key and
+    // the payload, the XOR has a constant trip count and the MAC is unrolled.
+
+    static constexpr size_t MAX_FIXED_LENGTH = 1024; // Longer messages belong on encrypt()/decrypt()
+
+    namespace detail {
+        template <size_t Len>
+        inline void mac_padded(Poly1305& p, const uint8_t* data) noexcept {
+            p.update_blocks<Len / 16>(data);
+
+            if constexpr (Len % 16 != 0) {
+                uint8_t last[16] = { 0 };
+                std::memcpy(last, data + Len / 16 * 16, Len % 16);
+                p.update_blocks<1>(last);
+            }
+        }
+
+        template <size_t AadLen, size_t PtLen>
+        inline constexpr std::array<uint8_t, 16> LENGTH_BLOCK = [] {
+            std::array<uint8_t, 16> block{};
+            for (size_t i = 0; i < 8; i++) {
+                block[i] = static_cast<uint8_t>(uint64_t(AadLen) >> (8 * i));
+                block[8 + i] = static_cast<uint8_t>(uint64_t(PtLen) >> (8 * i));
+            }
+            return block;
+        }();
+
+        // Authenticator over aad | pad | ciphertext | pad | lengths, with p keyed from keystream block 0
+        template <size_t AadLen, size_t PtLen>
+        inline void mac_fixed(Poly1305& p, const uint8_t* keystream, const uint8_t* aad, const uint8_t* ciphertext, uint8_t tag[16]) noexcept {
+            p.reset(keystream);
+            mac_padded<AadLen>(p, aad);
+            mac_padded<PtLen>(p, ciphertext);
+            p.update_blocks<1>(LENGTH_BLOCK<AadLen, PtLen>.data());
+            p.final_(tag);
+        }
+    }
+
+    template <size_t AadLen, size_t PtLen>
+    inline void seal(
+        ChaCha20& c, Poly1305& p,
+        std::span<const uint8_t, AadLen> aad,
+        std::span<const uint8_t, PtLen> plaintext,
+        std::span<uint8_t, PtLen> output,
+        std::span<uint8_t, 16> tag) noexcept
+    {
+        static_assert(AadLen <= MAX_FIXED_LENGTH && PtLen <= MAX_FIXED_LENGTH, "Fixed-length AEAD is meant for short records");
+
+        Instrumentation::CallSample sample;
+        Instrumentation::record_aead(Instrumentation::AEAD_SEALS, PtLen);
+
+        // Block 0: Poly1305 key, blocks 1..: payload keystream
+        alignas(64) uint32_t keystream[16 * (1 + (PtLen + 63) / 64)];
+        c.keystream_at(0, keystream, sizeof(keystream) / 64);
+        const uint8_t* ks = reinterpret_cast<const uint8_t*>(keystream);
+
+        for (size_t i = 0; i < PtLen; i++) {
+            output[i] = plaintext[i] ^ ks[64 + i];
+        }
+
+        detail::mac_fixed<AadLen, PtLen>(p, ks, aad.data(), output.data(), tag.data());
+        CryptoHelper::secure_zero_memory(keystream, sizeof(keystream));
+    }
+
+    // False (output untouched) when authentication fails
+    template <size_t AadLen, size_t PtLen>
+    inline bool open(
+        ChaCha20& c, Poly1305& p,
+        std::span<const uint8_t, AadLen> aad,
+        std::span<const uint8_t, PtLen> ciphertext,
+        std::span<const uint8_t, 16> received_tag,
+        std::span<uint8_t, PtLen> output) noexcept
+    {
+        static_assert(AadLen <= MAX_FIXED_LENGTH && PtLen <= MAX_FIXED_LENGTH, "Fixed-length AEAD is meant for short records");
+
+        Instrumentation::CallSample sample;
+        Instrumentation::record_aead(Instrumentation::AEAD_OPENS, PtLen);
+
+        alignas(64) uint32_t keystream[16 * (1 + (PtLen + 63) / 64)];
+        c.keystream_at(0, keystream, sizeof(keystream) / 64);
+        const uint8_t* ks = reinterpret_cast<const uint8_t*>(keystream);
+
+        uint8_t calc_tag[16];
+        detail::mac_fixed<AadLen, PtLen>(p, ks, aad.data(), ciphertext.data(), calc_tag);
+
+        bool authentic = constant_time_compare(calc_tag, received_tag.data(), 16);
+        if (authentic) {
+            for (size_t i = 0; i < PtLen; i++) {
+                output[i] = ciphertext[i] ^ ks[64 + i];
+            }
+        }
+        else {
+            Instrumentation::add(Instrumentation::AUTH_FAILURES);
+        }
+
+        CryptoHelper::secure_zero_memory(keystream, sizeof(keystream));
+        return authentic;
+    }
+
+    // Without a caller-owned Poly1305 (each call then locks and unlocks a fresh one)
+
+    template <size_t AadLen, size_t PtLen>
+    inline void seal(ChaCha20& c, std::span<const uint8_t, AadLen> aad, std::span<const uint8_t, PtLen> plaintext,
+        std::span<uint8_t, PtLen> output, std::span<uint8_t, 16> tag) noexcept
+    {
+        Poly1305 p(std::nothrow);
+        seal<AadLen, PtLen>(c, p, aad, plaintext, output, tag);
+    }
+
+    template <size_t AadLen, size_t PtLen>
+    inline bool open(ChaCha20& c, std::span<const uint8_t, AadLen> aad, std::span<const uint8_t, PtLen> ciphertext,
+        std::span<const uint8_t, 16> received_tag, std::span<uint8_t, PtLen> output) noexcept
+    {
+        Poly1305 p(std::nothrow);
+        return open<AadLen, PtLen>(c, p, aad, ciphertext, received_tag, output);
+    }
+
+    // Streaming AEAD with resumable checkpoints
+
+    enum class StreamMode : uint8_t {
+        Seal = 1,
+        Open = 2
+    };
+
+    class Stream {
+    public:
+        // nonce(12) | sealed state | tag(16)
+        static constexpr size_t STATE_SIZE = 5 * 8 + 16 + 1 + 1 + 8 + 8;
+        static constexpr size_t CHECKPOINT_SIZE = 12 + STATE_SIZE + 16;
+
+        Stream(ChaCha20& c, StreamMode mode, const uint8_t* aad, size_t aad_len);
+        // Resumes from a checkpoint, throws unless c holds the same key and nonce as the original stream
+        Stream(ChaCha20& c, const uint32_t local_key[8], const uint8_t checkpoint[CHECKPOINT_SIZE]);
+
+        // noexcept resume in place: AuthenticationFailed for a tampered checkpoint or one from another
+        // stream, and the stream is then left as it was
+        CryptoHelper::Status try_resume(const uint32_t local_key[8], const uint8_t checkpoint[CHECKPOINT_SIZE]) noexcept;
+
+        // Encrypts (Seal) or decrypts (Open) the next chunk of the message
+        void update(const uint8_t* input, uint8_t* output, size_t length);
+
+        void finish(uint8_t tag[16]);
+        bool verify(const uint8_t received_tag[16]);
+
+        // Seals the in-progress state under a local key so the stream can be resumed later
+        void checkpoint(const uint32_t local_key[8], uint8_t out[CHECKPOINT_SIZE]) const;
+
+        size_t processed() const { return data_len; }
+
+        Stream(const Stream&) = delete;
+        Stream& operator=(const Stream&) = delete;
+    private:
+        ChaCha20& c;
+        Poly1305 p;
+        StreamMode mode;
+        uint64_t aad_len = 0;
+        uint64_t data_len = 0;
+
+        static constexpr uint8_t CHECKPOINT_LABEL[] = { 'C','C','2','0','P','1','3','0','5','-','C','K','P','T','-','2' };
+        static constexpr size_t CHECKPOINT_AAD_SIZE = sizeof(CHECKPOINT_LABEL) + 32;
+
+        // label | upper half of keystream block 0, which the AEAD never uses.
+        // Binds a checkpoint to the key and nonce of its stream without revealing either.
+        static void checkpoint_aad(ChaCha20& c, uint8_t aad[CHECKPOINT_AAD_SIZE]) noexcept {
+            alignas(64) uint8_t block[64] = { 0 };
+            c.set_counter(0);
+            c.try_process_cached(block, block, 64);
+
+            std::memcpy(aad, CHECKPOINT_LABEL, sizeof(CHECKPOINT_LABEL));
+            std::memcpy(aad + sizeof(CHECKPOINT_LABEL), block + 32, 32);
+            CryptoHelper::secure_zero_memory(block, sizeof(block));
+        }
+    };
+
+    inline Stream::Stream(ChaCha20& c, StreamMode mode, const uint8_t* aad, size_t aad_len)
+        : c(c), p(std::nothrow), mode(mode), aad_len(aad_len)
+    {
+        derive_mac_key(c, p);
+
+        if (aad_len) {
+            p.update(aad, aad_len);
+            poly_pad16(p, aad_len);
+        }
+    }
+
+    inline void Stream::update(const uint8_t* input, uint8_t* output, size_t length) {
+        if (length == 0) return;
+
+        if (length > (uint64_t(1) << 38) - 64 - data_len) {
+            CRYPTO_THROW(std::invalid_argument("Stream length exceeds the 2^32 block limit of a single nonce"));
+        }
+
+        if (mode == StreamMode::Open) {
+            p.update(input, length);
+        }
+
+        size_t done = 0;
+        size_t block_offset = data_len & 63;
+
+        // 1. Finish the keystream block left partially used by the previous chunk
+        if (block_offset) {
+            alignas(64) uint8_t keystream[64] = { 0 };
+            c.set_counter(static_cast<uint32_t>(1 + data_len / 64));
+            c.process(keystream, keystream, 64);
+
+            done = min_(length, 64 - block_offset);
+            process_manually(input, output, keystream + block_offset, done);
+            CryptoHelper::secure_zero_memory(keystream, sizeof(keystream));
+        }
+
+        // 2. Remaining bytes start on a block boundary
+        if (done < length) {
+            c.set_counter(static_cast<uint32_t>(1 + (data_len + done) / 64));
+            c.process(input + done, output + done, length - done);
+        }
+
+        if (mode == StreamMode::Seal) {
+            p.update(output, length);
+        }
+
+        data_len += length;
+    }
+
+    inline void Stream::finish(uint8_t tag[16]) {
+        poly_pad16(p, data_len);
+
+        uint8_t lengths[16];
+        CryptoHelper::store_le64(lengths, aad_len);
+        CryptoHelper::store_le64(lengths + 8, data_len);
+        p.update(lengths, 16);
+
+        p.final_(tag);
+    }
+
+    inline bool Stream::verify(const uint8_t received_tag[16]) {
+        uint8_t calc_tag[16];
+        finish(calc_tag);
+
+        return constant_time_compare(calc_tag, received_tag, 16);
+    }
+
+    inline void Stream::checkpoint(const uint32_t local_key[8], uint8_t out[CHECKPOINT_SIZE]) const {
+        Poly1305::State ps;
+        p.export_state(ps);
+
+        uint8_t state[STATE_SIZE];
+        for (size_t i = 0; i < 5; i++) {
+            CryptoHelper::store_le64(state + i * 8, ps.acc[i]);
+        }
+        std::memcpy(state + 40, ps.partial, 16);
+        state[56] = static_cast<uint8_t>(ps.partial_len);
+        state[57] = static_cast<uint8_t>(mode);
+        CryptoHelper::store_le64(state + 58, aad_len);
+        CryptoHelper::store_le64(state + 66, data_len);
+
+        uint32_t nonce[3];
+        CryptoHelper::gen_secure_random_bytes(out, 12);
+        CryptoHelper::_8bitarray_to32bitarray(out, nonce, 12);
+
+        uint8_t aad[CHECKPOINT_AAD_SIZE];
+        checkpoint_aad(c, aad);
+
+        ChaCha20 sealer(local_key, nonce);
+        encrypt(sealer, state, STATE_SIZE, aad, sizeof(aad), out + 12, out + 12 + STATE_SIZE);
+
+        CryptoHelper::secure_zero_memory(aad, sizeof(aad));
+        CryptoHelper::secure_zero_memory(state, sizeof(state));
+        CryptoHelper::secure_zero_memory(&ps, sizeof(ps));
+    }
+
+    inline CryptoHelper::Status Stream::try_resume(const uint32_t local_key[8], const uint8_t checkpoint[CHECKPOINT_SIZE]) noexcept {
+        if (!local_key || !checkpoint) {
+            return CryptoHelper::Status::NullPointer;
+        }
+
+        uint32_t nonce[3];
+        CryptoHelper::_8bitarray_to32bitarray(checkpoint, nonce, 12);
+
+        uint8_t aad[CHECKPOINT_AAD_SIZE];
+        checkpoint_aad(c, aad);
+
+        uint8_t state[STATE_SIZE];
+        ChaCha20 sealer(std::nothrow);
+        sealer.reset(local_key, nonce);
+
+        // Fails both for tampering and for a checkpoint taken from a different stream
+        CryptoHelper::Status status = try_decrypt(sealer, checkpoint + 12, STATE_SIZE, aad, sizeof(aad), checkpoint + 12 + STATE_SIZE, state);
+        CryptoHelper::secure_zero_memory(aad, sizeof(aad));
+
+        if (status != CryptoHelper::Status::Ok) {
+            return status;
+        }
+
+        Poly1305::State ps;
+        bool valid = state[56] < 16 &&
+            (state[57] == static_cast<uint8_t>(StreamMode::Seal) || state[57] == static_cast<uint8_t>(StreamMode::Open));
+
+        for (size_t i = 0; i < 5; i++) {
+            ps.acc[i] = CryptoHelper::load_le64(state + i * 8);
+            valid = valid && (ps.acc[i] >> 32) == 0;
+        }
+        std::memcpy(ps.partial, state + 40, 16);
+        ps.partial_len = state[56];
+
+        // Authentic but not a state this version writes: reject before touching the stream
+        if (!valid) {
+            CryptoHelper::secure_zero_memory(state, sizeof(state));
+            CryptoHelper::secure_zero_memory(&ps, sizeof(ps));
+            return CryptoHelper::Status::AuthenticationFailed;
+        }
+
+        mode = static_cast<StreamMode>(state[57]);
+        aad_len = CryptoHelper::load_le64(state + 58);
+        data_len = CryptoHelper::load_le64(state + 66);
+
+        CryptoHelper::secure_zero_memory(state, sizeof(state));
+
+        derive_mac_key(c, p);
+        p.import_state(ps);
+        CryptoHelper::secure_zero_memory(&ps, sizeof(ps));
+
+        return CryptoHelper::Status::Ok;
+    }
+
+    inline Stream::Stream(ChaCha20& c, const uint32_t local_key[8], const uint8_t checkpoint[CHECKPOINT_SIZE])
+        : c(c), p(std::nothrow), mode(StreamMode::Seal)
+    {
+        CryptoHelper::Status status = try_resume(local_key, checkpoint);
+
+        if (status == CryptoHelper::Status::AuthenticationFailed) {
+            CRYPTO_THROW(std::runtime_error("Checkpoint authentication failed"));
+        }
+
+        if (status != CryptoHelper::Status::Ok) {
+            CRYPTO_THROW(std::invalid_argument(CryptoHelper::status_message(status)));
+        }
+    }
+}
@@ -0,0 +1,373 @@
+#pragma once
+#include <chacha20_poly1305.hpp>
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(__linux__) || defined(__GLIBC__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// In-process seal/open service for servers with many request threads.
+//
+// Producers push jobs into a bounded lock-free MPMC queue; a fixed set of
+// worker threads, each optionally pinned to one CPU, pull up to MAX_BATCH jobs
+// at a time. The Poly1305 one-time keys of a whole batch come out of a single
+// 8-lane keystream pass (every lane has its own key and nonce), and each worker
+// keeps one locked ChaCha20/Poly1305 pair that it re-keys per job instead of
+// constructing (and mlocking) new state.
+//
+// Back-pressure: try_submit() fails when the queue is full, submit() and
+// submit_future() wait for a free slot.
+
+namespace CryptoService {
+    static constexpr size_t DEFAULT_QUEUE_CAPACITY = 1024;
+    static constexpr size_t MAX_BATCH = 8;          // One AVX2 pass derives all one-time keys of a batch
+    static constexpr unsigned IDLE_SPINS = 4096;    // Polls before an idle worker sleeps
+
+    // Bounded queue after Dmitry Vyukov's design: one sequence number per cell,
+    // producers and consumers each claim positions with a CAS. Capacity is a power of two.
+    template <typename T>
+    class MpmcQueue {
+    public:
+        explicit MpmcQueue(size_t capacity);
+
+        // Both fail instead of waiting; `value` is only moved from on success
+        bool try_push(T&& value);
+        bool try_pop(T& value);
+
+        size_t capacity() const { return mask + 1; }
+        size_t size_approx() const;
+
+        MpmcQueue(const MpmcQueue&) = delete;
+        MpmcQueue& operator=(const MpmcQueue&) = delete;
+    private:
+        struct alignas(64) Cell {
+            std::atomic<size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<Cell[]> cells;
+        size_t mask;
+        alignas(64) std::atomic<size_t> enqueue_pos{ 0 };
+        alignas(64) std::atomic<size_t> dequeue_pos{ 0 };
+    };
+
+    template <typename T>
+    MpmcQueue<T>::MpmcQueue(size_t capacity) {
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+            CRYPTO_THROW(std::invalid_argument("Queue capacity must be a power of two of at least 2"));
+        }
+
+        cells.reset(new Cell[capacity]);
+        mask = capacity - 1;
+
+        for (size_t i = 0; i < capacity; ++i) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    template <typename T>
+    bool MpmcQueue<T>::try_push(T&& value) {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+            if (diff == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = std::move(value);
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false; // Full
+            }
+            else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    template <typename T>
+    bool MpmcQueue<T>::try_pop(T& value) {
+        size_t pos = dequeue_pos.load(std::memory_order_relaxed);
+
+        for (;;) {
+            Cell& cell = cells[pos & mask];
+            size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+            if (diff == 0) {
+                if (dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    value = std::move(cell.value);
+                    cell.value = T{}; // Don't leave a copy of the job (and its key) in the slot
+                    cell.sequence.store(pos + mask + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0) {
+                return false; // Empty
+            }
+            else {
+                pos = dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    template <typename T>
+    size_t MpmcQueue<T>::size_approx() const {
+        size_t head = dequeue_pos.load(std::memory_order_relaxed);
+        size_t tail = enqueue_pos.load(std::memory_order_relaxed);
+        return tail > head ? tail - head : 0;
+    }
+
+    enum class Operation : uint8_t { Seal, Open };
+
+    // Runs on a worker thread and must not throw
+    using Completion = std::function<void(CryptoHelper::Status)>;
+
+    // All buffers must stay valid until the completion runs.
+    // Seal writes `tag`, Open reads the received tag from it.
+    struct Job {
+        Operation op = Operation::Seal;
+        uint32_t key[8] = { 0 };
+        uint32_t nonce[3] = { 0 };
+        const uint8_t* input = nullptr;
+        size_t length = 0;
+        const uint8_t* aad = nullptr;
+        size_t aad_len = 0;
+        uint8_t* output = nullptr;
+        uint8_t* tag = nullptr;
+        Completion done;
+    };
+
+    class Service {
+    public:
+        // One worker per entry, pinned to that CPU (-1: not pinned). Queue capacity must be a power of two.
+        explicit Service(const std::vector<int>& worker_cpus, size_t queue_capacity = DEFAULT_QUEUE_CAPACITY);
+
+        // Finishes every queued job; stop submitting before destroying the service
+        ~Service();
+
+        // False when the queue is full (or the service is stopping); `job` is then left intact
+        bool try_submit(Job&& job);
+
+        // Waits for a free slot
+        void submit(Job&& job);
+        std::future<CryptoHelper::Status> submit_future(Job&& job);
+
+        size_t queued() const { return queue.size_approx(); }
+        size_t workers() const { return threads.size(); }
+
+        Service(const Service&) = delete;
+        Service& operator=(const Service&) = delete;
+    private:
+        MpmcQueue<Job> queue;
+        std::vector<std::thread> threads;
+        std::atomic<bool> stopping{ false };
+        std::atomic<uint32_t> epoch{ 0 }; // Bumped per submit, idle workers wait on it
+
+        void run(int cpu);
+        static void process_batch(ChaCha20& c, Poly1305& p, Job* batch, size_t count);
+        static void one_time_keys(const Job* batch, size_t count, uint8_t keys[MAX_BATCH][32]);
+        static bool pin_current_thread(int cpu);
+    };
+
+    inline Service::Service(const std::vector<int>& worker_cpus, size_t queue_capacity) : queue(queue_capacity) {
+        if (worker_cpus.empty()) {
+            CRYPTO_THROW(std::invalid_argument("Crypto service needs at least one worker"));
+        }
+
+        threads.reserve(worker_cpus.size());
+        for (int cpu : worker_cpus) {
+            threads.emplace_back([this, cpu] { run(cpu); });
+        }
+    }
+
+    inline Service::~Service() {
+        stopping.store(true, std::memory_order_release);
+        epoch.fetch_add(1, std::memory_order_release);
+        epoch.notify_all();
+
+        for (auto& t : threads) {
+            t.join();
+        }
+    }
+
+    inline bool Service::try_submit(Job&& job) {
+        if (stopping.load(std::memory_order_relaxed) || !queue.try_push(std::move(job))) return false;
+
+        epoch.fetch_add(1, std::memory_order_release);
+        epoch.notify_one();
+        return true;
+    }
+
+    inline void Service::submit(Job&& job) {
+        for (unsigned spins = 0; !try_submit(std::move(job)); ++spins) {
+            if (stopping.load(std::memory_order_relaxed)) {
+                CRYPTO_THROW(std::runtime_error("Crypto service is stopping"));
+            }
+
+            if (spins < IDLE_SPINS) _mm_pause();
+            else std::this_thread::yield();
+        }
+    }
+
+    inline std::future<CryptoHelper::Status> Service::submit_future(Job&& job) {
+        auto promise = std::make_shared<std::promise<CryptoHelper::Status>>();
+        std::future<CryptoHelper::Status> result = promise->get_future();
+
+        job.done = [promise](CryptoHelper::Status status) { promise->set_value(status); };
+        submit(std::move(job));
+
+        return result;
+    }
+
+    inline void Service::run(int cpu) {
+        if (cpu >= 0) pin_current_thread(cpu);
+
+        // Per-worker scratch, locked once and re-keyed for every job
+        ChaCha20 c(std::nothrow);
+        Poly1305 p(std::nothrow);
+        Job batch[MAX_BATCH];
+
+        for (;;) {
+            uint32_t seen = epoch.load(std::memory_order_acquire);
+
+            size_t count = 0;
+            while (count < MAX_BATCH && queue.try_pop(batch[count])) count++;
+
+            if (count) {
+                process_batch(c, p, batch, count);
+                continue;
+            }
+
+            if (stopping.load(std::memory_order_acquire)) return; // Stopping and drained
+
+            bool found = false;
+            for (unsigned spins = 0; spins < IDLE_SPINS && !found; ++spins) {
+                _mm_pause();
+                found = epoch.load(std::memory_order_relaxed) != seen;
+            }
+
+            if (!found) epoch.wait(seen, std::memory_order_acquire);
+        }
+    }
+
+    inline void Service::process_batch(ChaCha20& c, Poly1305& p, Job* batch, size_t count) {
+        alignas(32) uint8_t keys[MAX_BATCH][32];
+        one_time_keys(batch, count, keys);
+
+        for (size_t i = 0; i < count; ++i) {
+            Job& job = batch[i];
+
+            CryptoHelper::Status status = ChaCha20_Poly1305::check_arguments(job.input, job.output, job.length, job.aad, job.aad_len, job.tag);
+            if (status == CryptoHelper::Status::Ok) status = c.reset(job.key, job.nonce);
+
+            if (status == CryptoHelper::Status::Ok) {
+                p.reset(keys[i]);
+
+                status = job.op == Operation::Seal
+                    ? ChaCha20_Poly1305::seal_keyed(c, p, job.input, job.length, job.aad, job.aad_len, job.output, job.tag)
+                    : ChaCha20_Poly1305::open_keyed(c, p, job.input, job.length, job.aad, job.aad_len, job.tag, job.output);
+            }
+
+            CryptoHelper::secure_zero_memory(job.key, sizeof(job.key));
+
+            if (job.done) job.done(status);
+            job.done = nullptr;
+        }
+
+        CryptoHelper::secure_zero_memory(keys, sizeof(keys));
+    }
+
+    // First 32 bytes of keystream block 0 of every job
+    inline void Service::one_time_keys(const Job* batch, size_t count, uint8_t keys[MAX_BATCH][32]) {
+        Instrumentation::add(Instrumentation::KEYSTREAM_BLOCKS, count);
+
+#ifdef __AVX2__
+        if (count > 1) {
+            // Lane i holds job i's state; unused lanes repeat job 0
+            alignas(32) uint32_t lanes[11][8];
+            for (size_t lane = 0; lane < 8; ++lane) {
+                const Job& job = batch[lane < count ? lane : 0];
+                for (size_t w = 0; w < 8; ++w) lanes[w][lane] = job.key[w];
+                for (size_t w = 0; w < 3; ++w) lanes[8 + w][lane] = job.nonce[w];
+            }
+
+            __m256i in[16], x[16];
+            in[0] = _mm256_set1_epi32(0x61707865);
+            in[1] = _mm256_set1_epi32(0x3320646e);
+            in[2] = _mm256_set1_epi32(0x79622d32);
+            in[3] = _mm256_set1_epi32(0x6b206574);
+            for (size_t w = 0; w < 8; ++w) {
+                in[4 + w] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes[w]));
+            }
+            in[12] = _mm256_setzero_si256();
+            for (size_t w = 0; w < 3; ++w) {
+                in[13 + w] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes[8 + w]));
+            }
+
+            for (size_t w = 0; w < 16; ++w) x[w] = in[w];
+            chacha20_rounds_x8(x);
+
+            // Only words 0-7 form the Poly1305 key
+            alignas(32) uint32_t words[8][8];
+            for (size_t w = 0; w < 8; ++w) {
+                _mm256_store_si256(reinterpret_cast<__m256i*>(words[w]), _mm256_add_epi32(x[w], in[w]));
+            }
+
+            for (size_t lane = 0; lane < count; ++lane) {
+                for (size_t w = 0; w < 8; ++w) {
+                    std::memcpy(keys[lane] + w * 4, &words[w][lane], 4);
+                }
+            }
+
+            CryptoHelper::secure_zero_memory(lanes, sizeof(lanes));
+            CryptoHelper::secure_zero_memory(words, sizeof(words));
+            return;
+        }
+#endif
+
+        alignas(64) uint32_t state[16];
+        alignas(64) uint32_t block[16];
+
+        for (size_t i = 0; i < count; ++i) {
+            state[0] = 0x61707865; state[1] = 0x3320646e; state[2] = 0x79622d32; state[3] = 0x6b206574;
+            std::memcpy(state + 4, batch[i].key, sizeof(batch[i].key));
+            state[12] = 0;
+            std::memcpy(state + 13, batch[i].nonce, sizeof(batch[i].nonce));
+
+            ChaCha20::block_words(state, block);
+            std::memcpy(keys[i], block, 32);
+        }
+
+        CryptoHelper::secure_zero_memory(state, sizeof(state));
+        CryptoHelper::secure_zero_memory(block, sizeof(block));
+    }
+
+    inline bool Service::pin_current_thread(int cpu) {
+#if defined(_WIN32) || defined(_WIN64)
+        if (cpu >= 64) return false;
+        return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__) || defined(__GLIBC__)
+        if (cpu >= CPU_SETSIZE) return false;
+
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(cpu, &cpuset);
+        return pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+}
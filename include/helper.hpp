@@ -23,8 +23,51 @@
 #include <cstring>
 #include <string_view>
 #include <array>
+#include <type_traits>
+#include <new>
+#include <limits>
+#include <cstdlib>
+
+// Builds without exceptions (-fno-exceptions, /EHs-c-) can only use the noexcept
+// try_* API; the throwing wrappers still compile there but abort instead of throwing.
+#if defined(__cpp_exceptions) || defined(_CPPUNWIND)
+#define CRYPTO_EXCEPTIONS 1
+#define CRYPTO_THROW(exception) throw exception
+#else
+#define CRYPTO_EXCEPTIONS 0
+#define CRYPTO_THROW(exception) std::abort()
+#endif
 
 namespace CryptoHelper {
+	// Error codes of the noexcept API
+
+    enum class Status : uint8_t {
+        Ok = 0,
+        NullPointer,          // A required pointer was null (with a non-zero length)
+        MessageTooLong,       // Beyond the 2^32 block limit of a single nonce
+        AuthenticationFailed, // Tag mismatch, nothing was decrypted
+        RandomUnavailable,    // The OS random source failed
+        SequenceExhausted,    // Every nonce of a sequence was used, rekey
+        RecordTooLarge,       // A length prefix beyond the record limit
+        Truncated,            // The peer closed the connection in the middle of a record
+        IoError               // A socket call failed, errno holds the reason
+    };
+
+    constexpr const char* status_message(Status status) {
+        switch (status) {
+        case Status::Ok: return "Success";
+        case Status::NullPointer: return "A required buffer, key or nonce was null";
+        case Status::MessageTooLong: return "Message exceeds the 2^32 block limit of a single nonce";
+        case Status::AuthenticationFailed: return "Authentication failed";
+        case Status::RandomUnavailable: return "The system random generator failed";
+        case Status::SequenceExhausted: return "Record sequence exhausted, rekey the channel";
+        case Status::RecordTooLarge: return "Record exceeds the maximum record size";
+        case Status::Truncated: return "Connection closed in the middle of a record";
+        case Status::IoError: return "Socket I/O failed";
+        }
+        return "Unknown error";
+    }
+
 	// Memory helpers
 
     inline void secure_zero_memory(void* ptr, size_t len) {
@@ -63,6 +106,164 @@ namespace CryptoHelper {
 #endif
     }
 
+    // Aligned buffer allocation
+
+    static constexpr size_t BUFFER_ALIGNMENT = 64;
+    static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+    enum BufferFlags : uint32_t {
+        BUFFER_DEFAULT = 0,
+        BUFFER_HUGE_PAGES = 1 << 0,          // Transparent huge pages (madvise) for large buffers
+        BUFFER_EXPLICIT_HUGE_PAGES = 1 << 1, // MAP_HUGETLB / MEM_LARGE_PAGES, falls back to transparent
+        BUFFER_NUMA_LOCAL = 1 << 2,          // Prefer the calling thread's NUMA node for the pages
+        BUFFER_LOCK = 1 << 3,                // mlock/VirtualLock the buffer
+        BUFFER_WIPE_ON_FREE = 1 << 4         // Securely zero before releasing
+    };
+
+    // Large or page-level requests are page mapped, small ones come from aligned operator new
+    inline bool buffer_is_mapped(size_t size, uint32_t flags) {
+        return (flags & (BUFFER_EXPLICIT_HUGE_PAGES | BUFFER_NUMA_LOCAL)) ||
+            ((flags & BUFFER_HUGE_PAGES) && size >= HUGE_PAGE_SIZE);
+    }
+
+    inline size_t buffer_mapped_size(size_t size, uint32_t flags) {
+        size_t granule = (flags & (BUFFER_HUGE_PAGES | BUFFER_EXPLICIT_HUGE_PAGES)) ? HUGE_PAGE_SIZE : 4096;
+        return (size + granule - 1) & ~(granule - 1);
+    }
+
+#if defined(__linux__)
+    inline void bind_to_local_numa_node(void* ptr, size_t len) {
+        unsigned cpu = 0, node = 0;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) != 0) return;
+
+        constexpr int MPOL_PREFERRED_ = 1; // <numaif.h> is not always installed
+        unsigned long nodemask[16] = { 0 };
+        if (node >= sizeof(nodemask) * 8) return;
+        nodemask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+
+        // Best effort: kernels without NUMA support return ENOSYS
+        syscall(SYS_mbind, ptr, len, MPOL_PREFERRED_, nodemask, sizeof(nodemask) * 8, 0);
+    }
+#endif
+
+    inline void* alloc_buffer(size_t size, uint32_t flags = BUFFER_DEFAULT) {
+        if (size == 0) size = 1;
+
+        void* ptr = nullptr;
+
+        if (!buffer_is_mapped(size, flags)) {
+            ptr = ::operator new(size, std::align_val_t(BUFFER_ALIGNMENT));
+        }
+        else {
+            size_t len = buffer_mapped_size(size, flags);
+#if defined(_WIN32) || defined(_WIN64)
+            if (flags & BUFFER_EXPLICIT_HUGE_PAGES) {
+                size_t large = GetLargePageMinimum();
+                if (large && len % large == 0) {
+                    ptr = VirtualAlloc(nullptr, len, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+                }
+            }
+
+            if (!ptr && (flags & BUFFER_NUMA_LOCAL)) {
+                PROCESSOR_NUMBER proc;
+                USHORT node = 0;
+                GetCurrentProcessorNumberEx(&proc);
+                if (GetNumaProcessorNodeEx(&proc, &node)) {
+                    ptr = VirtualAllocExNuma(GetCurrentProcess(), nullptr, len, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE, node);
+                }
+            }
+
+            if (!ptr) {
+                ptr = VirtualAlloc(nullptr, len, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+            }
+
+            if (!ptr) CRYPTO_THROW(std::bad_alloc());
+#elif defined(__linux__)
+            if (flags & BUFFER_EXPLICIT_HUGE_PAGES) {
+                ptr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (ptr == MAP_FAILED) ptr = nullptr; // No reserved huge pages, fall back to THP
+            }
+
+            if (!ptr) {
+                size_t granule = (flags & (BUFFER_HUGE_PAGES | BUFFER_EXPLICIT_HUGE_PAGES)) ? HUGE_PAGE_SIZE : 0;
+
+                // Over-map so the region can be trimmed to a huge page boundary
+                void* raw = mmap(nullptr, len + granule, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (raw == MAP_FAILED) CRYPTO_THROW(std::bad_alloc());
+
+                uintptr_t base = reinterpret_cast<uintptr_t>(raw);
+                uintptr_t aligned = granule ? (base + granule - 1) & ~(uintptr_t)(granule - 1) : base;
+                if (aligned > base) munmap(raw, aligned - base);
+                if (granule && base + granule > aligned) munmap(reinterpret_cast<void*>(aligned + len), base + granule - aligned);
+
+                ptr = reinterpret_cast<void*>(aligned);
+
+                if (granule) madvise(ptr, len, MADV_HUGEPAGE);
+            }
+
+            if (flags & BUFFER_NUMA_LOCAL) bind_to_local_numa_node(ptr, len);
+#else
+            ptr = ::operator new(len, std::align_val_t(BUFFER_ALIGNMENT));
+#endif
+        }
+
+        if (flags & BUFFER_LOCK) {
+            lock_memory(ptr, size);
+        }
+
+        return ptr;
+    }
+
+    inline void free_buffer(void* ptr, size_t size, uint32_t flags = BUFFER_DEFAULT) {
+        if (!ptr) return;
+        if (size == 0) size = 1;
+
+        if (flags & BUFFER_WIPE_ON_FREE) secure_zero_memory(ptr, size);
+        if (flags & BUFFER_LOCK) unlock_memory(ptr, size);
+
+        if (!buffer_is_mapped(size, flags)) {
+            ::operator delete(ptr, std::align_val_t(BUFFER_ALIGNMENT));
+            return;
+        }
+
+#if defined(_WIN32) || defined(_WIN64)
+        VirtualFree(ptr, 0, MEM_RELEASE);
+#elif defined(__linux__)
+        munmap(ptr, buffer_mapped_size(size, flags));
+#else
+        ::operator delete(ptr, std::align_val_t(BUFFER_ALIGNMENT));
+#endif
+    }
+
+    // STL-compatible allocator over alloc_buffer/free_buffer
+    template <typename T, uint32_t Flags = BUFFER_HUGE_PAGES>
+    struct BufferAllocator {
+        using value_type = T;
+
+        template <typename U>
+        struct rebind { using other = BufferAllocator<U, Flags>; };
+
+        BufferAllocator() noexcept = default;
+
+        template <typename U>
+        BufferAllocator(const BufferAllocator<U, Flags>&) noexcept {}
+
+        T* allocate(size_t n) {
+            if (n > std::numeric_limits<size_t>::max() / sizeof(T)) CRYPTO_THROW(std::bad_array_new_length());
+            return static_cast<T*>(alloc_buffer(n * sizeof(T), Flags));
+        }
+
+        void deallocate(T* ptr, size_t n) noexcept {
+            free_buffer(ptr, n * sizeof(T), Flags);
+        }
+
+        template <typename U>
+        bool operator==(const BufferAllocator<U, Flags>&) const noexcept { return true; }
+    };
+
+    template <typename T = uint8_t, uint32_t Flags = BUFFER_HUGE_PAGES>
+    using buffer_vector = std::vector<T, BufferAllocator<T, Flags>>;
+
     // Byte array bit-size conversion
 
     inline void _8bitarray_to32bitarray(const uint8_t* byteArray, uint32_t* _32bitArray, size_t byteLength) {
@@ -85,6 +286,54 @@ namespace CryptoHelper {
     }
 
 
+    // Little-endian loads/stores (byte-wise when constant evaluated)
+
+    constexpr uint32_t load_le32(const uint8_t* bytes) {
+        if (std::is_constant_evaluated()) {
+            return (uint32_t)bytes[0] |
+                (uint32_t)bytes[1] << 8 |
+                (uint32_t)bytes[2] << 16 |
+                (uint32_t)bytes[3] << 24;
+        }
+
+        uint32_t value;
+        std::memcpy(&value, bytes, sizeof(uint32_t));
+        return value;
+    }
+
+    constexpr uint64_t load_le64(const uint8_t* bytes) {
+        if (std::is_constant_evaluated()) {
+            return (uint64_t)load_le32(bytes) | (uint64_t)load_le32(bytes + 4) << 32;
+        }
+
+        uint64_t value;
+        std::memcpy(&value, bytes, sizeof(uint64_t));
+        return value;
+    }
+
+    constexpr void store_le32(uint8_t* bytes, uint32_t value) {
+        if (std::is_constant_evaluated()) {
+            for (size_t i = 0; i < 4; ++i) {
+                bytes[i] = (uint8_t)(value >> (8 * i));
+            }
+            return;
+        }
+
+        std::memcpy(bytes, &value, sizeof(uint32_t));
+    }
+
+    constexpr void store_le64(uint8_t* bytes, uint64_t value) {
+        if (std::is_constant_evaluated()) {
+            for (size_t i = 0; i < 8; ++i) {
+                bytes[i] = (uint8_t)(value >> (8 * i));
+            }
+            return;
+        }
+
+        std::memcpy(bytes, &value, sizeof(uint64_t));
+    }
+
+
     // Conversion helper
 
     inline std::vector<uint8_t> string_to_bytes(std::string s) {
@@ -106,10 +355,13 @@ namespace CryptoHelper {
 
 	// Random byte generation
 
-    inline void gen_secure_random_bytes(uint8_t* buffer, size_t length) {
+    inline Status try_gen_secure_random_bytes(uint8_t* buffer, size_t length) noexcept {
+        if (length == 0) return Status::Ok;
+        if (!buffer) return Status::NullPointer;
+
 #if defined(_WIN32) || defined(_WIN64)
         if (!BCRYPT_SUCCESS(BCryptGenRandom(NULL, buffer, static_cast<ULONG>(length), BCRYPT_USE_SYSTEM_PREFERRED_RNG))) {
-            throw std::runtime_error("BCryptGenRandom failed");
+            return Status::RandomUnavailable;
         }
 #elif defined(__linux__)
         size_t total_read = 0;
@@ -118,12 +370,21 @@ namespace CryptoHelper {
 
             if (result == -1) {
                 if (errno == EINTR) continue;
-                throw std::runtime_error("getrandom failed: " + std::to_string(errno));
+                return Status::RandomUnavailable;
             }
             total_read += result;
         }
 #else
-        throw std::runtime_error("Platform not supported");
+        return Status::RandomUnavailable;
 #endif
+
+        return Status::Ok;
+    }
+
+    inline void gen_secure_random_bytes(uint8_t* buffer, size_t length) {
+        Status status = try_gen_secure_random_bytes(buffer, length);
+        if (status != Status::Ok) {
+            CRYPTO_THROW(std::runtime_error(status_message(status)));
+        }
     }
 }
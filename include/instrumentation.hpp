@@ -0,0 +1,192 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <immintrin.h>
+
+// Optional hot-path counters. Define CHACHA20_INSTRUMENTATION (CMake option of
+// the same name) to compile them in; otherwise every hook is an empty inline
+// function behind `if constexpr` and generates no code.
+//
+// Each thread owns a cache-line aligned block of counters and is the only writer,
+// so updates are plain relaxed load/store pairs (no locked instructions).
+// snapshot() sums live threads plus the totals of threads that already exited.
+
+namespace Instrumentation {
+#if defined(CHACHA20_INSTRUMENTATION)
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    enum Counter : size_t {
+        CIPHER_BYTES,      // Bytes through ChaCha20::process
+        KEYSTREAM_BLOCKS,  // 64-byte blocks generated
+        POLY1305_BLOCKS,   // 16-byte blocks absorbed
+        AEAD_SEALS,
+        AEAD_OPENS,
+        AUTH_FAILURES,     // decrypt() tag mismatches
+        AEAD_BYTES,        // Sum of AEAD message sizes
+        SAMPLED_CALLS,
+        SAMPLED_CYCLES,
+        COUNTER_COUNT
+    };
+
+    static constexpr size_t SIZE_BUCKETS = 33;  // le 2^0 .. 2^31, then +Inf
+    static constexpr uint64_t SAMPLE_EVERY = 64; // One AEAD call in N is timed
+
+    struct alignas(64) ThreadCounters {
+        std::atomic<uint64_t> values[COUNTER_COUNT]{};
+        std::atomic<uint64_t> sizes[SIZE_BUCKETS]{};
+        uint64_t sample_tick = 0; // Owner thread only
+    };
+
+    struct Snapshot {
+        uint64_t values[COUNTER_COUNT]{};
+        uint64_t sizes[SIZE_BUCKETS]{};
+    };
+
+    struct Registry {
+        std::mutex lock;
+        std::vector<ThreadCounters*> live;
+        Snapshot retired;
+    };
+
+    inline Registry& registry() {
+        static Registry r;
+        return r;
+    }
+
+    struct ThreadSlot {
+        ThreadCounters* counters = new ThreadCounters;
+
+        ThreadSlot() {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> guard(r.lock);
+            r.live.push_back(counters);
+        }
+
+        ~ThreadSlot() {
+            Registry& r = registry();
+            {
+                std::lock_guard<std::mutex> guard(r.lock);
+                for (size_t i = 0; i < COUNTER_COUNT; i++) r.retired.values[i] += counters->values[i].load(std::memory_order_relaxed);
+                for (size_t i = 0; i < SIZE_BUCKETS; i++) r.retired.sizes[i] += counters->sizes[i].load(std::memory_order_relaxed);
+                std::erase(r.live, counters);
+            }
+            delete counters;
+        }
+    };
+
+    inline ThreadCounters& local() {
+        thread_local ThreadSlot slot;
+        return *slot.counters;
+    }
+
+    inline void bump(std::atomic<uint64_t>& value, uint64_t n) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    // Hooks
+
+    inline void add(Counter counter, uint64_t n = 1) {
+        if constexpr (ENABLED) {
+            bump(local().values[counter], n);
+        }
+    }
+
+    inline void record_aead(Counter kind, uint64_t message_size) {
+        if constexpr (ENABLED) {
+            ThreadCounters& t = local();
+            size_t bucket = message_size <= 1 ? 0 : static_cast<size_t>(std::bit_width(message_size - 1));
+            if (bucket >= SIZE_BUCKETS) bucket = SIZE_BUCKETS - 1;
+
+            bump(t.values[kind], 1);
+            bump(t.values[AEAD_BYTES], message_size);
+            bump(t.sizes[bucket], 1);
+        }
+    }
+
+    // Times one call in SAMPLE_EVERY with the TSC
+    class CallSample {
+    public:
+        CallSample() {
+            if constexpr (ENABLED) {
+                active = (local().sample_tick++ % SAMPLE_EVERY) == 0;
+                if (active) start = __rdtsc();
+            }
+        }
+
+        ~CallSample() {
+            if constexpr (ENABLED) {
+                if (active) {
+                    uint64_t cycles = __rdtsc() - start;
+                    add(SAMPLED_CALLS);
+                    add(SAMPLED_CYCLES, cycles);
+                }
+            }
+        }
+
+        CallSample(const CallSample&) = delete;
+        CallSample& operator=(const CallSample&) = delete;
+    private:
+        uint64_t start = 0;
+        bool active = false;
+    };
+
+    // Export
+
+    inline Snapshot snapshot() {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+
+        Snapshot s = r.retired;
+        for (ThreadCounters* t : r.live) {
+            for (size_t i = 0; i < COUNTER_COUNT; i++) s.values[i] += t->values[i].load(std::memory_order_relaxed);
+            for (size_t i = 0; i < SIZE_BUCKETS; i++) s.sizes[i] += t->sizes[i].load(std::memory_order_relaxed);
+        }
+
+        return s;
+    }
+
+    // Prometheus text exposition format
+    inline std::string to_prometheus(const Snapshot& s) {
+        std::string out;
+
+        auto counter = [&](const char* name, const char* help, uint64_t value) {
+            out += std::string("# HELP ") + name + " " + help + "\n";
+            out += std::string("# TYPE ") + name + " counter\n";
+            out += std::string(name) + " " + std::to_string(value) + "\n";
+        };
+
+        counter("chacha20_cipher_bytes_total", "Bytes processed by ChaCha20.", s.values[CIPHER_BYTES]);
+        counter("chacha20_keystream_blocks_total", "64-byte ChaCha20 keystream blocks generated.", s.values[KEYSTREAM_BLOCKS]);
+        counter("poly1305_blocks_total", "16-byte blocks absorbed by Poly1305.", s.values[POLY1305_BLOCKS]);
+        counter("chacha20_poly1305_seals_total", "AEAD encrypt calls.", s.values[AEAD_SEALS]);
+        counter("chacha20_poly1305_opens_total", "AEAD decrypt calls.", s.values[AEAD_OPENS]);
+        counter("chacha20_poly1305_auth_failures_total", "AEAD decrypt calls rejected by the tag check.", s.values[AUTH_FAILURES]);
+
+        out += "# HELP chacha20_poly1305_call_cycles TSC cycles per sampled AEAD call.\n";
+        out += "# TYPE chacha20_poly1305_call_cycles summary\n";
+        out += "chacha20_poly1305_call_cycles_sum " + std::to_string(s.values[SAMPLED_CYCLES]) + "\n";
+        out += "chacha20_poly1305_call_cycles_count " + std::to_string(s.values[SAMPLED_CALLS]) + "\n";
+
+        out += "# HELP chacha20_poly1305_message_bytes AEAD message size distribution.\n";
+        out += "# TYPE chacha20_poly1305_message_bytes histogram\n";
+
+        uint64_t cumulative = 0;
+        for (size_t i = 0; i < SIZE_BUCKETS; i++) {
+            cumulative += s.sizes[i];
+            std::string le = (i + 1 == SIZE_BUCKETS) ? "+Inf" : std::to_string(1ULL << i);
+            out += "chacha20_poly1305_message_bytes_bucket{le=\"" + le + "\"} " + std::to_string(cumulative) + "\n";
+        }
+
+        out += "chacha20_poly1305_message_bytes_sum " + std::to_string(s.values[AEAD_BYTES]) + "\n";
+        out += "chacha20_poly1305_message_bytes_count " + std::to_string(cumulative) + "\n";
+
+        return out;
+    }
+}
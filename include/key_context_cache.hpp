@@ -0,0 +1,199 @@
+#pragma once
+#include <chacha20.hpp>
+#include <array>
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+// Sharded LRU cache of session keys keyed by session ID.
+// An entry is one cache line: the key, immutable once cached, and the session's
+// next nonce sequence, consumed atomically. Each record is sealed by loading the
+// entry into a cipher the caller owns (typically one ChaCha20(std::nothrow) per
+// thread, locked once), so threads sharing a session never share cipher state
+// and never reuse a nonce. ChaCha20 has no key schedule, so that load is a copy
+// of 11 words; what the cache saves is the lookup, allocation and mlock.
+//
+// Nonce = 4 zero bytes | sequence (LE64), as in SessionTable.
+// Entries are handed out as shared_ptr so an eviction never wipes a key a caller
+// is still loading; the allocator wipes an entry once its last owner drops it.
+
+template <size_t Shards = 64>
+class KeyContextCache {
+    static_assert(Shards > 0 && (Shards & (Shards - 1)) == 0, "Shard count must be a power of two");
+public:
+    class alignas(64) SessionKey {
+    public:
+        SessionKey(const uint32_t key[8], uint64_t first_sequence) : next_sequence(first_sequence) {
+            std::memcpy(this->key, key, sizeof(this->key));
+        }
+
+        // Keys c for the session's next record and returns its sequence (send it alongside the record).
+        // Each call, from any thread, consumes a distinct sequence.
+        uint64_t load_next(ChaCha20& c) {
+            uint64_t sequence = next_sequence.load(std::memory_order_relaxed);
+            do {
+                if (sequence == UINT64_MAX) {
+                    CRYPTO_THROW(std::runtime_error("Nonce sequence exhausted, rekey the session"));
+                }
+            } while (!next_sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_relaxed));
+
+            load(c, sequence);
+            return sequence;
+        }
+
+        // Keys c for a record sealed under `sequence` (the receive side; replay checking is left to the caller)
+        void load(ChaCha20& c, uint64_t sequence) const noexcept {
+            uint32_t nonce[3] = { 0, static_cast<uint32_t>(sequence), static_cast<uint32_t>(sequence >> 32) };
+            c.reset(key, nonce);
+        }
+
+        ~SessionKey() { CryptoHelper::secure_zero_memory(key, sizeof(key)); }
+
+        SessionKey(const SessionKey&) = delete;
+        SessionKey& operator=(const SessionKey&) = delete;
+    private:
+        uint32_t key[8];
+        std::atomic<uint64_t> next_sequence;
+    };
+
+    static_assert(sizeof(SessionKey) == 64, "A session key entry should fill exactly one cache line");
+
+    using Context = std::shared_ptr<SessionKey>;
+
+    explicit KeyContextCache(size_t capacity);
+
+    // nullptr on miss
+    Context find(uint64_t session_id);
+
+    // Returns the cached entry, or caches one from key whose first record uses first_sequence
+    Context get_or_insert(uint64_t session_id, const uint32_t key[8], uint64_t first_sequence = 0);
+
+    void erase(uint64_t session_id);
+    void clear();
+    size_t size();
+
+    KeyContextCache(const KeyContextCache&) = delete;
+    KeyContextCache& operator=(const KeyContextCache&) = delete;
+private:
+    struct Entry {
+        uint64_t session_id;
+        Context context;
+    };
+
+    // Shards sit on their own cache lines so lock traffic on one does not bounce the others
+    struct alignas(64) Shard {
+        std::mutex lock;
+        std::list<Entry> lru; // Most recently used at the front
+        std::unordered_map<uint64_t, typename std::list<Entry>::iterator> index;
+    };
+
+    std::array<Shard, Shards> shards;
+    size_t shard_capacity;
+
+    static size_t shard_of(uint64_t session_id) {
+        // splitmix64 finalizer, session IDs are often sequential
+        uint64_t z = session_id + 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return static_cast<size_t>(z ^ (z >> 31)) & (Shards - 1);
+    }
+};
+
+template <size_t Shards>
+inline KeyContextCache<Shards>::KeyContextCache(size_t capacity)
+    : shard_capacity((capacity + Shards - 1) / Shards)
+{
+    if (capacity == 0) {
+        CRYPTO_THROW(std::invalid_argument("Cache capacity must be greater than zero"));
+    }
+}
+
+template <size_t Shards>
+inline typename KeyContextCache<Shards>::Context KeyContextCache<Shards>::find(uint64_t session_id) {
+    Shard& shard = shards[shard_of(session_id)];
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    auto it = shard.index.find(session_id);
+    if (it == shard.index.end()) return nullptr;
+
+    shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+    return it->second->context;
+}
+
+template <size_t Shards>
+inline typename KeyContextCache<Shards>::Context KeyContextCache<Shards>::get_or_insert(uint64_t session_id, const uint32_t key[8], uint64_t first_sequence) {
+    if (Context cached = find(session_id)) {
+        return cached;
+    }
+
+    // Allocated before taking the shard lock so a miss does not hold up hits on other sessions
+    if (!key) {
+        CRYPTO_THROW(std::invalid_argument("Key must not be null"));
+    }
+
+    // Through the aligned allocator: make_shared would not keep the entry on its own cache line
+    Context prepared = std::allocate_shared<SessionKey>(CryptoHelper::BufferAllocator<SessionKey, CryptoHelper::BUFFER_WIPE_ON_FREE>(), key, first_sequence);
+    Context evicted; // Released after the lock so the wipe happens outside it
+
+    Shard& shard = shards[shard_of(session_id)];
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    // Another thread may have inserted the session while this one was preparing it
+    auto it = shard.index.find(session_id);
+    if (it != shard.index.end()) {
+        shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+        return it->second->context;
+    }
+
+    if (shard.lru.size() >= shard_capacity) {
+        Entry& victim = shard.lru.back();
+        shard.index.erase(victim.session_id);
+        evicted = std::move(victim.context);
+        shard.lru.pop_back();
+    }
+
+    shard.lru.push_front(Entry{ session_id, std::move(prepared) });
+    shard.index.emplace(session_id, shard.lru.begin());
+
+    return shard.lru.front().context;
+}
+
+template <size_t Shards>
+inline void KeyContextCache<Shards>::erase(uint64_t session_id) {
+    Shard& shard = shards[shard_of(session_id)];
+    Context removed;
+
+    std::lock_guard<std::mutex> guard(shard.lock);
+
+    auto it = shard.index.find(session_id);
+    if (it == shard.index.end()) return;
+
+    removed = std::move(it->second->context);
+    shard.lru.erase(it->second);
+    shard.index.erase(it);
+}
+
+template <size_t Shards>
+inline void KeyContextCache<Shards>::clear() {
+    for (Shard& shard : shards) {
+        std::list<Entry> removed;
+        {
+            std::lock_guard<std::mutex> guard(shard.lock);
+            removed.swap(shard.lru);
+            shard.index.clear();
+        }
+    }
+}
+
+template <size_t Shards>
+inline size_t KeyContextCache<Shards>::size() {
+    size_t total = 0;
+    for (Shard& shard : shards) {
+        std::lock_guard<std::mutex> guard(shard.lock);
+        total += shard.lru.size();
+    }
+
+    return total;
+}
@@ -7,21 +7,25 @@
 #include <helper.hpp>
 #include <vector>
 #include <algorithm>
+#include <utility>
 
 #define mask26 0x3FFFFFF
 
+namespace Benchmarking { struct PrimitiveAccess; }
+
 struct Poly1305 {
 private:
+	friend struct Benchmarking::PrimitiveAccess;
+
 	alignas(16) uint64_t r[5];
 	alignas(16) uint64_t s[2];
 	alignas(16) uint64_t acc[5]{ 0 };
 	alignas(32) uint8_t partial[16];
 	size_t partial_len = 0;
 
-	inline void bytes_to_limbs(const uint8_t* bytes, uint64_t* limbs, bool is_message_block = false, size_t l = 16) {
-		uint64_t low, high;
-		std::memcpy(&low, bytes, 8);
-		std::memcpy(&high, bytes + 8, 8);
+	static constexpr void bytes_to_limbs(const uint8_t* bytes, uint64_t* limbs, bool is_message_block = false, size_t l = 16) {
+		uint64_t low = CryptoHelper::load_le64(bytes);
+		uint64_t high = CryptoHelper::load_le64(bytes + 8);
 	
 		limbs[0] = low & mask26;
 		limbs[1] = (low >> 26) & mask26;
@@ -36,9 +40,9 @@ private:
 		limbs[limb_idx] |= (1ULL << bit_in_limb);
 	}
 
-	void mul_mod_p(uint64_t* r, uint64_t* acc);
+	static constexpr void mul_mod_p(const uint64_t* r, uint64_t* acc);
 
-	inline void add_limbs(uint64_t* a, const uint64_t* b) {
+	static constexpr void add_limbs(uint64_t* a, const uint64_t* b) {
 		uint64_t carry = 0;
 
 		for (size_t i = 0; i < 5; i++) {
@@ -54,16 +58,25 @@ private:
 		a[1] += carry;
 	}
 
+	static constexpr void load_key(const uint8_t key[32], uint64_t* r, uint64_t* s);
+	static constexpr void finish_tag(uint64_t* acc, const uint64_t* s, uint8_t tag[16]);
+
 	inline void process_block(const uint8_t block[16], bool is_message_block, size_t block_size=16) {
 		uint64_t msg_limbs[5];
 		bytes_to_limbs(block, msg_limbs, is_message_block, block_size);
 		add_limbs(acc, msg_limbs);
 		mul_mod_p(r, acc);
+
+		Instrumentation::add(Instrumentation::POLY1305_BLOCKS);
 	}
 
 public:
 	Poly1305(uint8_t block[64]);
 
+	// Reusable scratch: locked once, keyed per message with reset()
+	explicit Poly1305(std::nothrow_t) noexcept;
+	void reset(const uint8_t key[32]) noexcept;
+
 	void update(const uint8_t* data, size_t len) {
 		size_t offset = 0;
 
@@ -93,8 +106,48 @@ public:
 		}
 	}
 
+	// Exactly N full 16-byte blocks, unrolled at compile time. No partial block may be pending.
+	template <size_t N>
+	void update_blocks(const uint8_t* data) noexcept {
+		[&]<size_t... I>(std::index_sequence<I...>) {
+			(process_block(data + I * 16, true), ...);
+		}(std::make_index_sequence<N>{});
+	}
+
 	void final_(uint8_t tag[16]);
 
+	// In-progress state (r and s are re-derived from the one-time key on restore)
+	struct State {
+		uint64_t acc[5];
+		uint8_t partial[16];
+		size_t partial_len;
+	};
+
+	void export_state(State& out) const {
+		std::memcpy(out.acc, acc, sizeof(acc));
+		std::memcpy(out.partial, partial, sizeof(partial));
+		out.partial_len = partial_len;
+	}
+
+	void import_state(const State& in) {
+		if (in.partial_len >= 16) {
+			CRYPTO_THROW(std::invalid_argument("Poly1305 partial block length must be less than 16"));
+		}
+
+		for (size_t i = 0; i < 5; i++) {
+			if (in.acc[i] >> 32) {
+				CRYPTO_THROW(std::invalid_argument("Poly1305 accumulator limb out of range"));
+			}
+		}
+
+		std::memcpy(acc, in.acc, sizeof(acc));
+		std::memcpy(partial, in.partial, sizeof(partial));
+		partial_len = in.partial_len;
+	}
+
+	// One-shot MAC over a contiguous message, usable in constant expressions
+	static constexpr void mac(const uint8_t key[32], const uint8_t* data, size_t len, uint8_t tag[16]);
+
 	void update_pad16(size_t len) {
 		size_t rem = len % 16;
 		if (rem == 0) return;
@@ -107,28 +160,38 @@ public:
 		CryptoHelper::secure_zero_memory(r, 5 * sizeof(uint64_t));
 		CryptoHelper::secure_zero_memory(s, 2 * sizeof(uint64_t));
 		CryptoHelper::secure_zero_memory(acc, 5 * sizeof(uint64_t));
+		CryptoHelper::secure_zero_memory(partial, sizeof(partial));
 		CryptoHelper::unlock_memory(this, sizeof(Poly1305));
 	}
 };
 
+inline Poly1305::Poly1305(std::nothrow_t) noexcept : r{ 0 }, s{ 0 }, partial{ 0 } {
+	CryptoHelper::lock_memory(this, sizeof(Poly1305));
+}
+
+inline void Poly1305::reset(const uint8_t key[32]) noexcept {
+	load_key(key, r, s);
+	std::memset(acc, 0, sizeof(acc));
+	CryptoHelper::secure_zero_memory(partial, sizeof(partial));
+	partial_len = 0;
+}
+
 inline Poly1305::Poly1305(uint8_t block[64]) {
 	CryptoHelper::lock_memory(this, sizeof(Poly1305));
 
-	block[3] &= 15;
-	block[7] &= 15;
-	block[11] &= 15;
-	block[15] &= 15;
-	block[4] &= 252;
-	block[8] &= 252;
-	block[12] &= 252;
-
-	uint32_t b0, b1, b2, b3;
-	std::memcpy(&b0, block, 4);
-	std::memcpy(&b1, block + 4, 4);
-	std::memcpy(&b2, block + 8, 4);
-	std::memcpy(&b3, block + 12, 4);
-
-	// Clamping
+	load_key(block, r, s);
+
+	// Initialize accumulator to zero
+	std::memset(acc, 0, 5 * sizeof(uint64_t));
+}
+
+constexpr void Poly1305::load_key(const uint8_t key[32], uint64_t* r, uint64_t* s) {
+	uint32_t b0 = CryptoHelper::load_le32(key);
+	uint32_t b1 = CryptoHelper::load_le32(key + 4);
+	uint32_t b2 = CryptoHelper::load_le32(key + 8);
+	uint32_t b3 = CryptoHelper::load_le32(key + 12);
+
+	// 1. Clamping
 	b0 &= 0x0FFFFFFF;
 	b1 &= 0x0FFFFFFC;
 	b2 &= 0x0FFFFFFC;
@@ -142,15 +205,12 @@ inline Poly1305::Poly1305(uint8_t block[64]) {
 	r[4] = (b3 >> 8) & mask26;
 
 	// 3. Load s as two 64-bit values
-	std::memcpy(&s[0], &block[16], 8);
-	std::memcpy(&s[1], &block[24], 8);
-
-	// Initialize accumulator to zero
-	std::memset(acc, 0, 5 * sizeof(uint64_t));
+	s[0] = CryptoHelper::load_le64(key + 16);
+	s[1] = CryptoHelper::load_le64(key + 24);
 }
 
 
-inline void Poly1305::mul_mod_p(uint64_t* r, uint64_t* acc) {
+constexpr void Poly1305::mul_mod_p(const uint64_t* r, uint64_t* acc) {
 	uint64_t a0 = acc[0], a1 = acc[1], a2 = acc[2], a3 = acc[3], a4 = acc[4];
 	uint64_t r0 = r[0], r1 = r[1], r2 = r[2], r3 = r[3], r4 = r[4];
 
@@ -187,6 +247,10 @@ inline void Poly1305::final_(uint8_t tag[16]) {
 		process_block(block, true, partial_len); // Pad partial blocks
 	}
 
+	finish_tag(acc, s, tag);
+}
+
+constexpr void Poly1305::finish_tag(uint64_t* acc, const uint64_t* s, uint8_t tag[16]) {
 	// 1. Fully reduce acc mod (2^130 - 5), starting with carry propagation
 	uint64_t c = 0;
 	for (int i = 0; i < 5; i++) {
@@ -195,6 +259,23 @@ inline void Poly1305::final_(uint8_t tag[16]) {
 		acc[i] &= mask26;
 	}
 
+	acc[0] += c * 5;
+	c = acc[0] >> 26; acc[0] &= mask26; acc[1] += c;
+
+	// Compute g = acc + 5 - 2^130 and keep it if it did not borrow (constant time select)
+	uint64_t g[5];
+	c = 5;
+	for (int i = 0; i < 5; i++) {
+		g[i] = acc[i] + c;
+		c = g[i] >> 26;
+		g[i] &= mask26;
+	}
+
+	uint64_t select = 0 - c; // all ones when acc >= p
+	for (int i = 0; i < 5; i++) {
+		acc[i] = (acc[i] & ~select) | (g[i] & select);
+	}
+
 	// 2. Serialize acc back to 128-bit
 	uint64_t low = acc[0] | (acc[1] << 26) | (acc[2] << 52);
 	uint64_t high = (acc[2] >> 12) | (acc[3] << 14) | (acc[4] << 40);
@@ -202,15 +283,44 @@ inline void Poly1305::final_(uint8_t tag[16]) {
 	// 3. Add s (the 128-bit key part) using 64-bit carry math
 	unsigned char carry = 0;
 	#if defined(_MSC_VER)
-		carry = _addcarry_u64(0, low, s[0], &low);
-		_addcarry_u64(carry, high, s[1], &high);
-	#else
-		low += s[0];
-		carry = (low < s[0]);
-		high += s[1] + carry;
+		if (!std::is_constant_evaluated()) {
+			carry = _addcarry_u64(0, low, s[0], &low);
+			_addcarry_u64(carry, high, s[1], &high);
+		}
+		else
 	#endif
+		{
+			low += s[0];
+			carry = (low < s[0]);
+			high += s[1] + carry;
+		}
 
 	// 4. Fast serialization to tag
-	std::memcpy(tag, &low, 8);
-	std::memcpy(tag + 8, &high, 8);
+	CryptoHelper::store_le64(tag, low);
+	CryptoHelper::store_le64(tag + 8, high);
 }
+
+constexpr void Poly1305::mac(const uint8_t key[32], const uint8_t* data, size_t len, uint8_t tag[16]) {
+	uint64_t r[5]{}, s[2]{}, acc[5]{}, msg_limbs[5]{};
+	load_key(key, r, s);
+
+	size_t offset = 0;
+	for (; offset + 16 <= len; offset += 16) {
+		bytes_to_limbs(data + offset, msg_limbs, true);
+		add_limbs(acc, msg_limbs);
+		mul_mod_p(r, acc);
+	}
+
+	if (offset < len) {
+		uint8_t block[16]{};
+		for (size_t i = 0; i < len - offset; ++i) {
+			block[i] = data[offset + i];
+		}
+
+		bytes_to_limbs(block, msg_limbs, true, len - offset);
+		add_limbs(acc, msg_limbs);
+		mul_mod_p(r, acc);
+	}
+
+	finish_tag(acc, s, tag);
+}
\ No newline at end of file
@@ -0,0 +1,213 @@
+#pragma once
+#include <chacha20_poly1305.hpp>
+#include <cstdint>
+
+// QUIC-style packet protection (RFC 9001 sections 5.3 and 5.4.4)
+
+namespace QuicProtection {
+    static constexpr size_t TAG_SIZE = 16;
+    static constexpr size_t SAMPLE_SIZE = 16;
+    static constexpr size_t MASK_SIZE = 5;
+    static constexpr size_t MASK_BATCH = 8;
+
+    // Header protection masks
+
+    // mask = ChaCha20(hp_key, counter = sample[0..3], nonce = sample[4..15], {0,0,0,0,0})
+    inline void header_mask(const uint32_t hp_key[8], const uint8_t sample[SAMPLE_SIZE], uint8_t mask[MASK_SIZE]) {
+        alignas(64) uint32_t state[16] = {
+            0x61707865, 0x3320646e, 0x79622d32, 0x6b206574,
+            hp_key[0], hp_key[1], hp_key[2], hp_key[3],
+            hp_key[4], hp_key[5], hp_key[6], hp_key[7],
+            CryptoHelper::load_le32(sample),
+            CryptoHelper::load_le32(sample + 4),
+            CryptoHelper::load_le32(sample + 8),
+            CryptoHelper::load_le32(sample + 12)
+        };
+        alignas(64) uint32_t block[16];
+
+        ChaCha20::block_words(state, block);
+
+        std::memcpy(mask, block, MASK_SIZE);
+        CryptoHelper::secure_zero_memory(block, sizeof(block));
+    }
+
+#ifdef __AVX2__
+    // Eight independent blocks, one per sample, each lane holding one packet's state
+    inline void header_masks_x8(const uint32_t hp_key[8], const uint8_t* samples, uint8_t* masks) {
+        alignas(32) uint32_t lanes[4][8];
+        for (size_t lane = 0; lane < 8; ++lane) {
+            for (size_t w = 0; w < 4; ++w) {
+                lanes[w][lane] = CryptoHelper::load_le32(samples + lane * SAMPLE_SIZE + w * 4);
+            }
+        }
+
+        __m256i x[16];
+        x[0] = _mm256_set1_epi32(0x61707865);
+        x[1] = _mm256_set1_epi32(0x3320646e);
+        x[2] = _mm256_set1_epi32(0x79622d32);
+        x[3] = _mm256_set1_epi32(0x6b206574);
+        for (size_t i = 0; i < 8; ++i) {
+            x[4 + i] = _mm256_set1_epi32(static_cast<int>(hp_key[i]));
+        }
+        for (size_t i = 0; i < 4; ++i) {
+            x[12 + i] = _mm256_load_si256(reinterpret_cast<const __m256i*>(lanes[i]));
+        }
+
+        chacha20_rounds_x8(x);
+
+        // Only keystream words 0 and 1 feed the 5-byte mask
+        alignas(32) uint32_t word0[8], word1[8];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(word0), _mm256_add_epi32(x[0], _mm256_set1_epi32(0x61707865)));
+        _mm256_store_si256(reinterpret_cast<__m256i*>(word1), _mm256_add_epi32(x[1], _mm256_set1_epi32(0x3320646e)));
+
+        for (size_t lane = 0; lane < 8; ++lane) {
+            std::memcpy(masks + lane * MASK_SIZE, &word0[lane], 4);
+            masks[lane * MASK_SIZE + 4] = static_cast<uint8_t>(word1[lane]);
+        }
+    }
+#endif
+
+    // samples: count * 16 contiguous bytes, masks: count * 5 bytes
+    inline void header_masks(const uint32_t hp_key[8], const uint8_t* samples, size_t count, uint8_t* masks) {
+        size_t i = 0;
+
+#ifdef __AVX2__
+        for (; i + 8 <= count; i += 8) {
+            header_masks_x8(hp_key, samples + i * SAMPLE_SIZE, masks + i * MASK_SIZE);
+        }
+#endif
+
+        for (; i < count; ++i) {
+            header_mask(hp_key, samples + i * SAMPLE_SIZE, masks + i * MASK_SIZE);
+        }
+    }
+
+    // Packet layout: header (packet number at pn_offset) | payload | tag
+    // The header protection sample is read 4 bytes past pn_offset whatever pn_len is, so a packet must
+    // hold at least pn_offset + MIN_BYTES_AFTER_PN bytes (RFC 9001 5.4.2: pad short payloads).
+    // protect_headers checks this; before unprotect_headers, check the received length against it.
+    static constexpr size_t MIN_BYTES_AFTER_PN = 4 + SAMPLE_SIZE;
+
+    struct Packet {
+        uint8_t* data;
+        size_t pn_offset;
+        size_t pn_len;      // 1-4, filled in by unprotect_headers
+        size_t payload_len; // Excluding the tag
+
+        size_t header_len() const { return pn_offset + pn_len; }
+        size_t size() const { return header_len() + payload_len + TAG_SIZE; }
+        const uint8_t* sample() const { return data + pn_offset + 4; }
+    };
+
+    class PacketProtection {
+    public:
+        PacketProtection(const uint8_t key[32], const uint8_t iv[12], const uint8_t hp_key[32]);
+
+        ~PacketProtection() {
+            CryptoHelper::secure_zero_memory(iv, sizeof(iv));
+            CryptoHelper::secure_zero_memory(hp_key, sizeof(hp_key));
+        }
+
+        // AEAD over the payload in place, header is the AAD and the tag follows the payload
+        void seal(Packet& packet, uint64_t packet_number);
+        bool open(Packet& packet, uint64_t packet_number);
+
+        // Batched header protection, call after seal / before open
+        void protect_headers(Packet* packets, size_t count);
+        void unprotect_headers(Packet* packets, size_t count);
+
+        PacketProtection(const PacketProtection&) = delete;
+        PacketProtection& operator=(const PacketProtection&) = delete;
+    private:
+        ChaCha20 c;
+        uint8_t iv[12];
+        uint32_t hp_key[8];
+
+        void set_packet_nonce(uint64_t packet_number);
+        void apply_masks(Packet* packets, size_t count, bool unprotect);
+    };
+
+    inline PacketProtection::PacketProtection(const uint8_t key[32], const uint8_t iv[12], const uint8_t hp_key[32])
+        : c(std::nothrow)
+    {
+        uint32_t key_words[8], zero_nonce[3] = { 0 };
+        CryptoHelper::_8bitarray_to32bitarray(key, key_words, 32);
+        c.reset(key_words, zero_nonce);
+        CryptoHelper::secure_zero_memory(key_words, sizeof(key_words));
+
+        std::memcpy(this->iv, iv, sizeof(this->iv));
+        CryptoHelper::_8bitarray_to32bitarray(hp_key, this->hp_key, 32);
+    }
+
+    // nonce = iv XOR packet number (big endian, left padded to 12 bytes)
+    inline void PacketProtection::set_packet_nonce(uint64_t packet_number) {
+        uint8_t nonce_bytes[12];
+        std::memcpy(nonce_bytes, iv, 12);
+
+        for (size_t i = 0; i < 8; ++i) {
+            nonce_bytes[11 - i] ^= static_cast<uint8_t>(packet_number >> (8 * i));
+        }
+
+        uint32_t nonce[3];
+        CryptoHelper::_8bitarray_to32bitarray(nonce_bytes, nonce, 12);
+        c.set_nonce(nonce);
+    }
+
+    inline void PacketProtection::seal(Packet& packet, uint64_t packet_number) {
+        set_packet_nonce(packet_number);
+
+        uint8_t* payload = packet.data + packet.header_len();
+        ChaCha20_Poly1305::encrypt(c, payload, packet.payload_len, packet.data, packet.header_len(), payload, payload + packet.payload_len);
+    }
+
+    inline bool PacketProtection::open(Packet& packet, uint64_t packet_number) {
+        set_packet_nonce(packet_number);
+
+        uint8_t* payload = packet.data + packet.header_len();
+        return ChaCha20_Poly1305::decrypt(c, payload, packet.payload_len, packet.data, packet.header_len(), payload + packet.payload_len, payload);
+    }
+
+    inline void PacketProtection::apply_masks(Packet* packets, size_t count, bool unprotect) {
+        alignas(32) uint8_t samples[MASK_BATCH * SAMPLE_SIZE];
+        uint8_t masks[MASK_BATCH * MASK_SIZE];
+
+        for (size_t base = 0; base < count; base += MASK_BATCH) {
+            size_t n = min_(count - base, MASK_BATCH);
+
+            for (size_t i = 0; i < n; ++i) {
+                if (!unprotect && packets[base + i].size() < packets[base + i].pn_offset + MIN_BYTES_AFTER_PN) {
+                    CRYPTO_THROW(std::invalid_argument("Packet too short for a header protection sample"));
+                }
+
+                std::memcpy(samples + i * SAMPLE_SIZE, packets[base + i].sample(), SAMPLE_SIZE);
+            }
+
+            header_masks(hp_key, samples, n, masks);
+
+            for (size_t i = 0; i < n; ++i) {
+                Packet& p = packets[base + i];
+                const uint8_t* mask = masks + i * MASK_SIZE;
+
+                // Long headers protect the low 4 bits of the first byte, short headers the low 5
+                p.data[0] ^= mask[0] & ((p.data[0] & 0x80) ? 0x0f : 0x1f);
+                if (unprotect) {
+                    p.pn_len = (p.data[0] & 0x03) + 1;
+                }
+
+                for (size_t j = 0; j < p.pn_len; ++j) {
+                    p.data[p.pn_offset + j] ^= mask[1 + j];
+                }
+            }
+        }
+
+        CryptoHelper::secure_zero_memory(masks, sizeof(masks));
+    }
+
+    inline void PacketProtection::protect_headers(Packet* packets, size_t count) {
+        apply_masks(packets, count, false);
+    }
+
+    inline void PacketProtection::unprotect_headers(Packet* packets, size_t count) {
+        apply_masks(packets, count, true);
+    }
+}
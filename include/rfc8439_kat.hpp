@@ -0,0 +1,170 @@
+#pragma once
+#include <chacha20.hpp>
+#include <poly1305.hpp>
+#include <cstdint>
+#include <array>
+
+// RFC 8439 known-answer tests, evaluated at compile time.
+// Any change to the scalar block function or the Poly1305 limb arithmetic
+// that breaks these vectors fails the build instead of failing at runtime.
+
+namespace RFC8439_KAT {
+    // Constexpr helpers
+
+    constexpr bool bytes_equal(const uint8_t* a, const uint8_t* b, size_t len) {
+        for (size_t i = 0; i < len; ++i) {
+            if (a[i] != b[i]) return false;
+        }
+
+        return true;
+    }
+
+    constexpr void init_state(uint32_t state[16], const uint8_t key[32], uint32_t counter, const uint8_t nonce[12]) {
+        state[0] = 0x61707865; // "expa"
+        state[1] = 0x3320646e; // "nd 3"
+        state[2] = 0x79622d32; // "2-by"
+        state[3] = 0x6b206574; // "te k"
+
+        for (size_t i = 0; i < 8; ++i) {
+            state[4 + i] = CryptoHelper::load_le32(key + i * 4);
+        }
+
+        state[12] = counter;
+
+        for (size_t i = 0; i < 3; ++i) {
+            state[13 + i] = CryptoHelper::load_le32(nonce + i * 4);
+        }
+    }
+
+    constexpr void keystream_xor(uint32_t state[16], const uint8_t* input, uint8_t* output, size_t length) {
+        uint32_t block[16]{};
+
+        for (size_t offset = 0; offset < length; offset += 64) {
+            ChaCha20::block_words(state, block);
+            state[12]++;
+
+            for (size_t i = 0; i < 64 && offset + i < length; ++i) {
+                output[offset + i] = input[offset + i] ^ (uint8_t)(block[i / 4] >> (8 * (i % 4)));
+            }
+        }
+    }
+
+    constexpr size_t pad16(size_t len) {
+        return (len + 15) & ~size_t(15);
+    }
+
+    template <size_t AadLen, size_t PtLen>
+    constexpr void seal(const uint8_t key[32], const uint8_t nonce[12], const uint8_t* aad, const uint8_t* plaintext, uint8_t* output, uint8_t tag[16]) {
+        uint32_t state[16]{};
+        init_state(state, key, 0, nonce);
+
+        // 1. Poly1305 one-time key (counter = 0)
+        uint8_t key_block[64]{};
+        keystream_xor(state, key_block, key_block, 64);
+
+        // 2. Encrypt plaintext (counter = 1)
+        keystream_xor(state, plaintext, output, PtLen);
+
+        // 3. aad | pad | ciphertext | pad | lengths (LE64)
+        std::array<uint8_t, pad16(AadLen) + pad16(PtLen) + 16> mac_data{};
+        for (size_t i = 0; i < AadLen; ++i) mac_data[i] = aad[i];
+        for (size_t i = 0; i < PtLen; ++i) mac_data[pad16(AadLen) + i] = output[i];
+        CryptoHelper::store_le64(mac_data.data() + pad16(AadLen) + pad16(PtLen), AadLen);
+        CryptoHelper::store_le64(mac_data.data() + pad16(AadLen) + pad16(PtLen) + 8, PtLen);
+
+        Poly1305::mac(key_block, mac_data.data(), mac_data.size(), tag);
+    }
+
+    // Section 2.3.2: ChaCha20 block function
+
+    constexpr bool chacha20_block() {
+        constexpr uint8_t key[32] = {
+            0x00,0x01,0x02,0x03,0x04,0x05,0x06,0x07,0x08,0x09,0x0a,0x0b,0x0c,0x0d,0x0e,0x0f,
+            0x10,0x11,0x12,0x13,0x14,0x15,0x16,0x17,0x18,0x19,0x1a,0x1b,0x1c,0x1d,0x1e,0x1f
+        };
+        constexpr uint8_t nonce[12] = { 0x00,0x00,0x00,0x09,0x00,0x00,0x00,0x4a,0x00,0x00,0x00,0x00 };
+        constexpr uint32_t expected[16] = {
+            0xe4e7f110, 0x15593bd1, 0x1fdd0f50, 0xc47120a3,
+            0xc7f4d1c7, 0x0368c033, 0x9aaa2204, 0x4e6cd4c3,
+            0x466482d2, 0x09aa9f07, 0x05d7c214, 0xa2028bd9,
+            0xd19c12b5, 0xb94e16de, 0xe883d0cb, 0x4e3c50a2
+        };
+
+        uint32_t state[16]{};
+        uint32_t output[16]{};
+        init_state(state, key, 1, nonce);
+        ChaCha20::block_words(state, output);
+
+        for (size_t i = 0; i < 16; ++i) {
+            if (output[i] != expected[i]) return false;
+        }
+
+        return true;
+    }
+
+    // Section 2.5.2 and Appendix A.3 #5 (final reduction mod 2^130 - 5)
+
+    constexpr bool poly1305_mac() {
+        constexpr uint8_t key[32] = {
+            0x85,0xd6,0xbe,0x78,0x57,0x55,0x6d,0x33,0x7f,0x44,0x52,0xfe,0x42,0xd5,0x06,0xa8,
+            0x01,0x03,0x80,0x8a,0xfb,0x0d,0xb2,0xfd,0x4a,0xbf,0xf6,0xaf,0x41,0x49,0xf5,0x1b
+        };
+        constexpr uint8_t message[34] = {
+            'C','r','y','p','t','o','g','r','a','p','h','i','c',' ','F','o','r','u','m',' ',
+            'R','e','s','e','a','r','c','h',' ','G','r','o','u','p'
+        };
+        constexpr uint8_t expected[16] = {
+            0xa8,0x06,0x1d,0xc1,0x30,0x51,0x36,0xc6,0xc2,0x2b,0x8b,0xaf,0x0c,0x01,0x27,0xa9
+        };
+
+        uint8_t tag[16]{};
+        Poly1305::mac(key, message, sizeof(message), tag);
+        if (!bytes_equal(tag, expected, 16)) return false;
+
+        uint8_t edge_key[32]{ 0x02 };
+        uint8_t edge_message[16]{};
+        for (auto& b : edge_message) b = 0xff;
+        constexpr uint8_t edge_expected[16] = { 0x03 };
+
+        Poly1305::mac(edge_key, edge_message, sizeof(edge_message), tag);
+        return bytes_equal(tag, edge_expected, 16);
+    }
+
+    // Section 2.8.2: AEAD_CHACHA20_POLY1305 encryption
+
+    constexpr bool aead_seal() {
+        constexpr uint8_t key[32] = {
+            0x80,0x81,0x82,0x83,0x84,0x85,0x86,0x87,0x88,0x89,0x8a,0x8b,0x8c,0x8d,0x8e,0x8f,
+            0x90,0x91,0x92,0x93,0x94,0x95,0x96,0x97,0x98,0x99,0x9a,0x9b,0x9c,0x9d,0x9e,0x9f
+        };
+        constexpr uint8_t nonce[12] = { 0x07,0x00,0x00,0x00,0x40,0x41,0x42,0x43,0x44,0x45,0x46,0x47 };
+        constexpr uint8_t aad[12] = { 0x50,0x51,0x52,0x53,0xc0,0xc1,0xc2,0xc3,0xc4,0xc5,0xc6,0xc7 };
+        constexpr char plaintext[] = "Ladies and Gentlemen of the class of '99: If I could offer you only one tip for the future, sunscreen would be it.";
+        constexpr uint8_t expected_ct[114] = {
+            0xd3,0x1a,0x8d,0x34,0x64,0x8e,0x60,0xdb,0x7b,0x86,0xaf,0xbc,0x53,0xef,0x7e,0xc2,
+            0xa4,0xad,0xed,0x51,0x29,0x6e,0x08,0xfe,0xa9,0xe2,0xb5,0xa7,0x36,0xee,0x62,0xd6,
+            0x3d,0xbe,0xa4,0x5e,0x8c,0xa9,0x67,0x12,0x82,0xfa,0xfb,0x69,0xda,0x92,0x72,0x8b,
+            0x1a,0x71,0xde,0x0a,0x9e,0x06,0x0b,0x29,0x05,0xd6,0xa5,0xb6,0x7e,0xcd,0x3b,0x36,
+            0x92,0xdd,0xbd,0x7f,0x2d,0x77,0x8b,0x8c,0x98,0x03,0xae,0xe3,0x28,0x09,0x1b,0x58,
+            0xfa,0xb3,0x24,0xe4,0xfa,0xd6,0x75,0x94,0x55,0x85,0x80,0x8b,0x48,0x31,0xd7,0xbc,
+            0x3f,0xf4,0xde,0xf0,0x8e,0x4b,0x7a,0x9d,0xe5,0x76,0xd2,0x65,0x86,0xce,0xc6,0x4b,
+            0x61,0x16
+        };
+        constexpr uint8_t expected_tag[16] = {
+            0x1a,0xe1,0x0b,0x59,0x4f,0x09,0xe2,0x6a,0x7e,0x90,0x2e,0xcb,0xd0,0x60,0x06,0x91
+        };
+
+        uint8_t pt[114]{};
+        for (size_t i = 0; i < 114; ++i) pt[i] = (uint8_t)plaintext[i];
+
+        uint8_t ct[114]{};
+        uint8_t tag[16]{};
+        seal<12, 114>(key, nonce, aad, pt, ct, tag);
+
+        return bytes_equal(ct, expected_ct, 114) && bytes_equal(tag, expected_tag, 16);
+    }
+
+    static_assert(chacha20_block(), "ChaCha20 block function does not match RFC 8439 section 2.3.2");
+    static_assert(poly1305_mac(), "Poly1305 does not match RFC 8439 section 2.5.2 / A.3");
+    static_assert(aead_seal(), "ChaCha20-Poly1305 does not match RFC 8439 section 2.8.2");
+}
@@ -0,0 +1,306 @@
+#pragma once
+#include <chacha20_poly1305.hpp>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <span>
+#include <string>
+
+#if !defined(_WIN32) && !defined(_WIN64)
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+// Encrypted record layer over a connected stream socket (Unix domain or TCP).
+//
+// Record: length (LE32) | ciphertext | tag. The length header is the AAD,
+// and the nonce is 4 zero bytes | per-direction record sequence (LE64).
+// Small writes are coalesced into records of up to MAX_RECORD_SIZE bytes and
+// encrypted in place, and flush() sends every pending record with one sendmsg
+// (header, ciphertext and tag as separate iovecs). Receives pull as much as
+// fits into one buffer and open records in place.
+//
+// Like TLS, this is a byte stream: record boundaries do not follow write() calls.
+// Blocking sockets only. A failed or truncated record throws (try_read_record returns a Status instead)
+// and leaves the channel unusable.
+
+namespace SecureChannel {
+    static constexpr size_t HEADER_SIZE = 4;
+    static constexpr size_t TAG_SIZE = 16;
+    static constexpr size_t MAX_RECORD_SIZE = 16 * 1024;
+    static constexpr size_t MAX_FRAME_SIZE = HEADER_SIZE + MAX_RECORD_SIZE + TAG_SIZE;
+    static constexpr size_t SEND_BUFFER_SIZE = 256 * 1024; // Multiple of MAX_RECORD_SIZE
+    static constexpr size_t MAX_BATCH_RECORDS = SEND_BUFFER_SIZE / MAX_RECORD_SIZE;
+    static constexpr size_t RECV_BUFFER_SIZE = 256 * 1024;
+
+    static_assert(SEND_BUFFER_SIZE % MAX_RECORD_SIZE == 0, "Send buffer must hold whole records");
+    static_assert(RECV_BUFFER_SIZE >= MAX_FRAME_SIZE, "Receive buffer must hold a full record");
+
+    class FramedChannel {
+    public:
+        // Does not take ownership of fd. Each side's send_key is the peer's recv_key.
+        FramedChannel(int fd, const uint8_t send_key[32], const uint8_t recv_key[32]);
+
+        // Buffers data; sends only when the batch buffer fills up
+        void write(const uint8_t* data, size_t length);
+        void flush();
+
+        // Next record's plaintext, valid until the next call. Empty at end of stream.
+        std::span<const uint8_t> read_record();
+
+        // noexcept read_record: AuthenticationFailed for a forged record, RecordTooLarge, Truncated,
+        // IoError (errno set) or SequenceExhausted. After an error every later call returns it again.
+        CryptoHelper::Status try_read_record(std::span<const uint8_t>& record) noexcept;
+
+        FramedChannel(const FramedChannel&) = delete;
+        FramedChannel& operator=(const FramedChannel&) = delete;
+    private:
+        struct Frame {
+            uint8_t header[HEADER_SIZE];
+            uint8_t tag[TAG_SIZE];
+            size_t offset;
+            size_t length;
+        };
+
+        static constexpr uint32_t BUFFER_FLAGS = CryptoHelper::BUFFER_WIPE_ON_FREE;
+
+        int fd;
+        ChaCha20 send_cipher;
+        ChaCha20 recv_cipher;
+        uint64_t send_sequence = 0;
+        uint64_t recv_sequence = 0;
+        CryptoHelper::Status recv_status = CryptoHelper::Status::Ok;
+
+        // Send side: [sealed records | plaintext not yet sealed | free]
+        CryptoHelper::buffer_vector<uint8_t, BUFFER_FLAGS> send_buffer;
+        size_t send_sealed = 0;
+        size_t send_used = 0;
+        std::array<Frame, MAX_BATCH_RECORDS> frames;
+        size_t frame_count = 0;
+
+        // Receive side: bytes [recv_begin, recv_end) are received but not yet consumed
+        CryptoHelper::buffer_vector<uint8_t, BUFFER_FLAGS> recv_buffer;
+        size_t recv_begin = 0;
+        size_t recv_end = 0;
+
+        void seal_record(const uint8_t* plaintext, size_t length);
+        void send_frames();
+
+        static void set_key(ChaCha20& c, const uint8_t key[32]) {
+            if (!key) {
+                CRYPTO_THROW(std::invalid_argument("Key must not be null"));
+            }
+
+            uint32_t words[8], zero_nonce[3] = { 0 };
+            CryptoHelper::_8bitarray_to32bitarray(key, words, 32);
+            c.reset(words, zero_nonce);
+            CryptoHelper::secure_zero_memory(words, sizeof(words));
+        }
+
+        static CryptoHelper::Status next_sequence_nonce(ChaCha20& c, uint64_t& sequence) noexcept {
+            if (sequence == UINT64_MAX) {
+                return CryptoHelper::Status::SequenceExhausted;
+            }
+
+            uint32_t nonce[3] = { 0, static_cast<uint32_t>(sequence), static_cast<uint32_t>(sequence >> 32) };
+            c.set_nonce(nonce);
+            sequence++;
+            return CryptoHelper::Status::Ok;
+        }
+
+        [[noreturn]] static void throw_errno([[maybe_unused]] const char* what) {
+            CRYPTO_THROW(std::runtime_error(std::string(what) + ": " + std::strerror(errno)));
+        }
+    };
+
+    inline FramedChannel::FramedChannel(int fd, const uint8_t send_key[32], const uint8_t recv_key[32])
+        : fd(fd),
+        send_cipher(std::nothrow),
+        recv_cipher(std::nothrow),
+        send_buffer(SEND_BUFFER_SIZE),
+        recv_buffer(RECV_BUFFER_SIZE)
+    {
+        if (fd < 0) {
+            CRYPTO_THROW(std::invalid_argument("Socket descriptor must be valid"));
+        }
+
+        set_key(send_cipher, send_key);
+        set_key(recv_cipher, recv_key);
+    }
+
+    // Ciphertext goes to send_buffer + send_sealed; plaintext may already be there (in place)
+    inline void FramedChannel::seal_record(const uint8_t* plaintext, size_t length) {
+        Frame& frame = frames[frame_count++];
+        frame.offset = send_sealed;
+        frame.length = length;
+        CryptoHelper::store_le32(frame.header, static_cast<uint32_t>(length));
+
+        if (next_sequence_nonce(send_cipher, send_sequence) != CryptoHelper::Status::Ok) {
+            CRYPTO_THROW(std::runtime_error("Record sequence exhausted, rekey the channel"));
+        }
+
+        uint8_t* ciphertext = send_buffer.data() + send_sealed;
+        ChaCha20_Poly1305::encrypt(send_cipher, plaintext, length, frame.header, HEADER_SIZE, ciphertext, frame.tag);
+
+        send_sealed += length;
+        if (send_used < send_sealed) send_used = send_sealed;
+    }
+
+    inline void FramedChannel::write(const uint8_t* data, size_t length) {
+        if (!data && length) {
+            CRYPTO_THROW(std::invalid_argument("Data must not be null"));
+        }
+
+        while (length) {
+            if (send_used == SEND_BUFFER_SIZE) flush();
+
+            // A whole record straight from the caller's buffer: encryption is the only copy
+            if (send_used == send_sealed && length >= MAX_RECORD_SIZE) {
+                seal_record(data, MAX_RECORD_SIZE);
+                data += MAX_RECORD_SIZE;
+                length -= MAX_RECORD_SIZE;
+                continue;
+            }
+
+            size_t n = min_(SEND_BUFFER_SIZE - send_used, length);
+            std::memcpy(send_buffer.data() + send_used, data, n);
+            send_used += n;
+            data += n;
+            length -= n;
+        }
+    }
+
+    inline void FramedChannel::flush() {
+        while (send_sealed < send_used) {
+            size_t n = min_(MAX_RECORD_SIZE, send_used - send_sealed);
+            seal_record(send_buffer.data() + send_sealed, n);
+        }
+
+        if (frame_count) send_frames();
+    }
+
+    inline void FramedChannel::send_frames() {
+        iovec iov[MAX_BATCH_RECORDS * 3];
+        size_t iov_count = 0;
+
+        for (size_t i = 0; i < frame_count; ++i) {
+            Frame& frame = frames[i];
+            iov[iov_count++] = { frame.header, HEADER_SIZE };
+            iov[iov_count++] = { send_buffer.data() + frame.offset, frame.length };
+            iov[iov_count++] = { frame.tag, TAG_SIZE };
+        }
+
+        size_t first = 0;
+        while (first < iov_count) {
+            msghdr msg{};
+            msg.msg_iov = iov + first;
+            msg.msg_iovlen = iov_count - first;
+
+            ssize_t sent = sendmsg(fd, &msg, MSG_NOSIGNAL);
+            if (sent < 0) {
+                if (errno == EINTR) continue;
+                throw_errno("sendmsg failed");
+            }
+
+            // Skip what went out, trim a partially sent iovec
+            size_t remaining = static_cast<size_t>(sent);
+            while (first < iov_count && remaining >= iov[first].iov_len) {
+                remaining -= iov[first].iov_len;
+                first++;
+            }
+            if (remaining) {
+                iov[first].iov_base = static_cast<uint8_t*>(iov[first].iov_base) + remaining;
+                iov[first].iov_len -= remaining;
+            }
+        }
+
+        frame_count = 0;
+        send_sealed = 0;
+        send_used = 0;
+    }
+
+    inline std::span<const uint8_t> FramedChannel::read_record() {
+        std::span<const uint8_t> record;
+        CryptoHelper::Status status = try_read_record(record);
+
+        if (status == CryptoHelper::Status::AuthenticationFailed) {
+            CRYPTO_THROW(std::runtime_error("Record authentication failed"));
+        }
+
+        if (status == CryptoHelper::Status::IoError) {
+            throw_errno("recv failed");
+        }
+
+        if (status != CryptoHelper::Status::Ok) {
+            CRYPTO_THROW(std::runtime_error(CryptoHelper::status_message(status)));
+        }
+
+        return record;
+    }
+
+    inline CryptoHelper::Status FramedChannel::try_read_record(std::span<const uint8_t>& record) noexcept {
+        record = {};
+
+        // A failed channel stays failed: its receive sequence no longer matches the peer's
+        if (recv_status != CryptoHelper::Status::Ok) {
+            return recv_status;
+        }
+
+        for (;;) {
+            size_t available = recv_end - recv_begin;
+
+            if (available >= HEADER_SIZE) {
+                uint8_t* header = recv_buffer.data() + recv_begin;
+                uint32_t length = CryptoHelper::load_le32(header);
+
+                if (length > MAX_RECORD_SIZE) {
+                    return recv_status = CryptoHelper::Status::RecordTooLarge;
+                }
+
+                // write() never seals an empty record, so one on the wire is forged
+                if (length == 0) {
+                    return recv_status = CryptoHelper::Status::AuthenticationFailed;
+                }
+
+                if (available >= HEADER_SIZE + length + TAG_SIZE) {
+                    uint8_t* ciphertext = header + HEADER_SIZE;
+                    recv_begin += HEADER_SIZE + length + TAG_SIZE;
+
+                    CryptoHelper::Status status = next_sequence_nonce(recv_cipher, recv_sequence);
+                    if (status == CryptoHelper::Status::Ok) {
+                        status = ChaCha20_Poly1305::try_decrypt(recv_cipher, ciphertext, length, header, HEADER_SIZE, ciphertext + length, ciphertext);
+                    }
+
+                    if (status != CryptoHelper::Status::Ok) {
+                        return recv_status = status;
+                    }
+
+                    record = { ciphertext, length };
+                    return CryptoHelper::Status::Ok;
+                }
+            }
+
+            // Need more bytes. Move the partial record to the front if a full one might not fit behind it.
+            if (recv_begin == recv_end) {
+                recv_begin = recv_end = 0;
+            }
+            else if (RECV_BUFFER_SIZE - recv_begin < MAX_FRAME_SIZE) {
+                std::memmove(recv_buffer.data(), recv_buffer.data() + recv_begin, available);
+                recv_begin = 0;
+                recv_end = available;
+            }
+
+            ssize_t received = recv(fd, recv_buffer.data() + recv_end, RECV_BUFFER_SIZE - recv_end, 0);
+            if (received < 0) {
+                if (errno == EINTR) continue;
+                return recv_status = CryptoHelper::Status::IoError;
+            }
+
+            if (received == 0) {
+                return available ? (recv_status = CryptoHelper::Status::Truncated) : CryptoHelper::Status::Ok;
+            }
+
+            recv_end += static_cast<size_t>(received);
+        }
+    }
+}
+#endif
@@ -0,0 +1,200 @@
+#pragma once
+#include <chacha20_poly1305.hpp>
+#include <cstdint>
+#include <vector>
+
+// Compact per-connection key storage for very large session counts.
+// A session is only its 32-byte key and a 64-bit nonce sequence, kept in dense
+// arrays (structure of arrays) next to a live flag and a free-list slot:
+// 45 bytes per session instead of a locked ChaCha20 and Poly1305 each. One
+// cipher and one MAC per table are locked once, keyed for each seal/open and
+// cleared again before it returns. The key array is wiped on release; locking it
+// is opt-in (lock_keys), since 32 bytes per session soon exceeds RLIMIT_MEMLOCK.
+//
+// Nonce = 4 zero bytes | sequence (LE64), as suggested in RFC 8439 section 2.8.
+// Not thread-safe: serialize calls per table (or shard tables across threads).
+
+class SessionTable {
+public:
+    using Handle = uint32_t;
+
+    // lock_keys pins the key array in RAM and throws std::runtime_error if the OS refuses
+    explicit SessionTable(size_t capacity, bool lock_keys = false);
+    ~SessionTable();
+
+    // Throws std::runtime_error when the table is full
+    Handle add(const uint8_t key[32], uint64_t first_sequence = 0);
+    void remove(Handle session);
+
+    // Seals with the session's next sequence number and returns it (send it alongside the record)
+    uint64_t seal(Handle session,
+        const uint8_t* plaintext, size_t plaintext_len,
+        const uint8_t* aad, size_t aad_len,
+        uint8_t* output, uint8_t* tag);
+
+    // Opens a record sealed under `sequence`; replay checking is left to the caller
+    bool open(Handle session, uint64_t sequence,
+        const uint8_t* ciphertext, size_t ciphertext_len,
+        const uint8_t* aad, size_t aad_len,
+        const uint8_t* received_tag, uint8_t* output);
+
+    uint64_t next_sequence(Handle session) const;
+
+    size_t size() const { return capacity_ - free_slots.size(); }
+    size_t capacity() const { return capacity_; }
+
+    // Key, sequence, live flag and free-list slot
+    static constexpr size_t BYTES_PER_SESSION = 8 * sizeof(uint32_t) + sizeof(uint64_t) + sizeof(uint8_t) + sizeof(Handle);
+
+    SessionTable(const SessionTable&) = delete;
+    SessionTable& operator=(const SessionTable&) = delete;
+private:
+    CryptoHelper::buffer_vector<uint32_t, CryptoHelper::BUFFER_WIPE_ON_FREE> keys; // 8 words per session
+    CryptoHelper::buffer_vector<uint64_t, CryptoHelper::BUFFER_DEFAULT> sequences;
+    std::vector<uint8_t> live;
+    std::vector<Handle> free_slots;
+    size_t capacity_;
+    bool keys_locked = false;
+
+    // Scratch shared by every session of this table, keyed per call and cleared after it
+    ChaCha20 cipher{ std::nothrow };
+    Poly1305 mac{ std::nothrow };
+
+    void clear_scratch() noexcept {
+        static constexpr uint32_t zero_key[8] = { 0 };
+        static constexpr uint32_t zero_nonce[3] = { 0 };
+        cipher.reset(zero_key, zero_nonce);
+        mac.reset(reinterpret_cast<const uint8_t*>(zero_key));
+    }
+
+    void check(Handle session) const;
+
+    static size_t checked_capacity(size_t capacity) {
+        if (capacity == 0 || capacity > UINT32_MAX) {
+            CRYPTO_THROW(std::invalid_argument("Session table capacity must be between 1 and 2^32 - 1"));
+        }
+
+        return capacity;
+    }
+
+    static void nonce_words(uint64_t sequence, uint32_t nonce[3]) {
+        nonce[0] = 0;
+        nonce[1] = static_cast<uint32_t>(sequence);
+        nonce[2] = static_cast<uint32_t>(sequence >> 32);
+    }
+};
+
+inline SessionTable::SessionTable(size_t capacity, bool lock_keys)
+    : keys(checked_capacity(capacity) * 8), sequences(capacity), live(capacity), capacity_(capacity)
+{
+    if (lock_keys) {
+        if (!CryptoHelper::lock_memory(keys.data(), keys.size() * sizeof(uint32_t))) {
+            CRYPTO_THROW(std::runtime_error("Could not lock the session key array (check RLIMIT_MEMLOCK)"));
+        }
+        keys_locked = true;
+    }
+
+    // Hand out low slots first so the hot set stays packed at the front
+    free_slots.reserve(capacity);
+    for (size_t i = capacity; i-- > 0;) {
+        free_slots.push_back(static_cast<Handle>(i));
+    }
+}
+
+inline SessionTable::~SessionTable() {
+    if (keys_locked) {
+        CryptoHelper::unlock_memory(keys.data(), keys.size() * sizeof(uint32_t));
+    }
+}
+
+inline void SessionTable::check(Handle session) const {
+    if (session >= capacity_ || !live[session]) {
+        CRYPTO_THROW(std::invalid_argument("Unknown session handle"));
+    }
+}
+
+inline SessionTable::Handle SessionTable::add(const uint8_t key[32], uint64_t first_sequence) {
+    if (!key) {
+        CRYPTO_THROW(std::invalid_argument("Key must not be null"));
+    }
+
+    if (free_slots.empty()) {
+        CRYPTO_THROW(std::runtime_error("Session table is full"));
+    }
+
+    Handle session = free_slots.back();
+    free_slots.pop_back();
+
+    CryptoHelper::_8bitarray_to32bitarray(key, &keys[session * 8], 32);
+    sequences[session] = first_sequence;
+    live[session] = 1;
+
+    return session;
+}
+
+inline void SessionTable::remove(Handle session) {
+    check(session);
+
+    CryptoHelper::secure_zero_memory(&keys[session * 8], 8 * sizeof(uint32_t));
+    sequences[session] = 0;
+    live[session] = 0;
+    free_slots.push_back(session);
+}
+
+inline uint64_t SessionTable::next_sequence(Handle session) const {
+    check(session);
+    return sequences[session];
+}
+
+inline uint64_t SessionTable::seal(Handle session,
+    const uint8_t* plaintext, size_t plaintext_len,
+    const uint8_t* aad, size_t aad_len,
+    uint8_t* output, uint8_t* tag)
+{
+    check(session);
+
+    uint64_t sequence = sequences[session];
+    if (sequence == UINT64_MAX) {
+        CRYPTO_THROW(std::runtime_error("Nonce sequence exhausted, rekey the session"));
+    }
+
+    uint32_t nonce[3];
+    nonce_words(sequence, nonce);
+
+    cipher.reset(&keys[session * 8], nonce);
+    CryptoHelper::Status status = ChaCha20_Poly1305::try_encrypt(cipher, mac, plaintext, plaintext_len, aad, aad_len, output, tag);
+    clear_scratch();
+
+    if (status != CryptoHelper::Status::Ok) {
+        CRYPTO_THROW(std::invalid_argument(CryptoHelper::status_message(status)));
+    }
+
+    // Only consume the nonce once the record was produced
+    sequences[session] = sequence + 1;
+    return sequence;
+}
+
+inline bool SessionTable::open(Handle session, uint64_t sequence,
+    const uint8_t* ciphertext, size_t ciphertext_len,
+    const uint8_t* aad, size_t aad_len,
+    const uint8_t* received_tag, uint8_t* output)
+{
+    check(session);
+
+    uint32_t nonce[3];
+    nonce_words(sequence, nonce);
+
+    cipher.reset(&keys[session * 8], nonce);
+    CryptoHelper::Status status = ChaCha20_Poly1305::try_decrypt(cipher, mac, ciphertext, ciphertext_len, aad, aad_len, received_tag, output);
+    clear_scratch();
+
+    if (status == CryptoHelper::Status::AuthenticationFailed) {
+        return false;
+    }
+
+    if (status != CryptoHelper::Status::Ok) {
+        CRYPTO_THROW(std::invalid_argument(CryptoHelper::status_message(status)));
+    }
+
+    return true;
+}
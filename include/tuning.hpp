@@ -0,0 +1,49 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+// Per-machine size thresholds that pick between code paths at run time.
+// The defaults are conservative; Benchmarking::load_or_calibrate() (benchmarking/autotune.hpp)
+// measures them on the running CPU and installs the result with apply().
+
+namespace Tuning {
+    static constexpr size_t DISABLED = SIZE_MAX;
+
+    struct Config {
+#ifdef __AVX2__
+        size_t batch_threshold = 512;            // ChaCha20::process uses the 8-block keystream kernel from here
+#else
+        size_t batch_threshold = DISABLED;
+#endif
+        size_t non_temporal_threshold = DISABLED; // Default for new ChaCha20 objects
+        size_t offload_threshold = 64 * 1024;     // AsyncAEAD hands messages of this size to the worker pool
+    };
+
+    struct Active {
+        std::atomic<size_t> batch_threshold;
+        std::atomic<size_t> non_temporal_threshold;
+        std::atomic<size_t> offload_threshold;
+    };
+
+    inline Active& active() {
+        static Active a{ Config{}.batch_threshold, Config{}.non_temporal_threshold, Config{}.offload_threshold };
+        return a;
+    }
+
+    inline Config current() {
+        Active& a = active();
+        Config c;
+        c.batch_threshold = a.batch_threshold.load(std::memory_order_relaxed);
+        c.non_temporal_threshold = a.non_temporal_threshold.load(std::memory_order_relaxed);
+        c.offload_threshold = a.offload_threshold.load(std::memory_order_relaxed);
+        return c;
+    }
+
+    // ChaCha20 objects created before the call keep their own non-temporal threshold
+    inline void apply(const Config& c) {
+        Active& a = active();
+        a.batch_threshold.store(c.batch_threshold, std::memory_order_relaxed);
+        a.non_temporal_threshold.store(c.non_temporal_threshold, std::memory_order_relaxed);
+        a.offload_threshold.store(c.offload_threshold, std::memory_order_relaxed);
+    }
+}